@@ -0,0 +1,188 @@
+#pragma once
+
+#include "dijkstra_router.h"
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+/*
+ * Маршрутизатор, который на каждый запрос запускает двунаправленный A*. Оценка снизу lower_bound(u, v)
+ * веса пути из u в v задаёт потенциал p(v) = (lower_bound(v, to) - lower_bound(from, v)) / 2:
+ * прямой поиск упорядочивает вершины по весу плюс потенциал, обратный — по весу минус потенциал.
+ * Обоим поискам потенциалы сдвигают веса рёбер одинаково, поэтому поиски встречаются так же, как
+ * в двунаправленном алгоритме Дейкстры, но просматривают в основном вершины в сторону другого конца.
+ * Оценка должна быть согласована с весами рёбер: для каждого ребра u -> v веса w
+ * lower_bound(u, t) <= w + lower_bound(v, t) и lower_bound(s, v) <= lower_bound(s, u) + w.
+ * Память O(V + E) на обратный граф, предпосчёта нет.
+ * Кроме сложения и сравнения, Weight должен поддерживать вычитание, деление и умножение на число
+ */
+template<typename Weight>
+class AStarRouter : public RouterBase<Weight> {
+ private:
+  using Graph = DirectedWeightedGraph<Weight>;
+
+ public:
+  using typename RouterBase<Weight>::RouteInfo;
+  using LowerBound = std::function<Weight(VertexId from, VertexId to)>;
+
+  AStarRouter(const Graph &graph, LowerBound lower_bound);
+
+  std::optional <RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+ private:
+  static constexpr Weight ZERO_WEIGHT{};
+  static constexpr EdgeId NO_EDGE = SearchState<Weight>::NO_EDGE;
+
+  const Graph &graph_;
+  LowerBound lower_bound_;
+
+  // Обратный граф в CSR-представлении: номера рёбер, входящих в каждую вершину
+  std::vector<size_t> reverse_offsets_;
+  std::vector<EdgeId> reverse_edge_ids_;
+};
+
+template<typename Weight>
+AStarRouter<Weight>::AStarRouter(const Graph &graph, LowerBound lower_bound)
+    : graph_(graph), lower_bound_(std::move(lower_bound)) {
+  const size_t vertex_count = graph.GetVertexCount();
+  const EdgeId edge_count = graph.GetEdgeCount();
+  reverse_offsets_.assign(vertex_count + 1, 0);
+  for (EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+    const auto &edge = graph.GetEdge(edge_id);
+    if (edge.weight < ZERO_WEIGHT) {
+      throw std::domain_error("Edges' weights should be non-negative");
+    }
+    ++reverse_offsets_[edge.to + 1];
+  }
+  for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+    reverse_offsets_[vertex + 1] += reverse_offsets_[vertex];
+  }
+  reverse_edge_ids_.resize(edge_count);
+  std::vector<size_t> positions(reverse_offsets_.begin(), reverse_offsets_.end() - 1);
+  for (EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+    reverse_edge_ids_[positions[graph.GetEdge(edge_id).to]++] = edge_id;
+  }
+}
+
+template<typename Weight>
+std::optional<typename AStarRouter<Weight>::RouteInfo> AStarRouter<Weight>::BuildRoute(VertexId from,
+                                                                                       VertexId to) const {
+  const size_t vertex_count = graph_.GetVertexCount();
+  if (from >= vertex_count || to >= vertex_count) {
+    throw std::out_of_range("Vertex id is out of range");
+  }
+
+  auto &forward = SearchState<Weight>::ForCurrentThread(SearchDirection::Forward);
+  auto &backward = SearchState<Weight>::ForCurrentThread(SearchDirection::Backward);
+  forward.Prepare(vertex_count);
+  backward.Prepare(vertex_count);
+
+  // Потенциал вершины вычисляется, когда её впервые достигает любой из поисков, и дальше берётся из кэша
+  thread_local std::vector<Weight> thread_potentials;
+  auto &potentials = thread_potentials;
+  if (potentials.size() < vertex_count) {
+    potentials.resize(vertex_count);
+  }
+  auto potential = [this, &forward, &backward, &potentials, from, to](VertexId vertex) {
+    if (!forward.IsReached(vertex) && !backward.IsReached(vertex)) {
+      potentials[vertex] = (lower_bound_(vertex, to) - lower_bound_(from, vertex)) / 2;
+    }
+    return potentials[vertex];
+  };
+
+  const Weight from_potential = potential(from);
+  forward.Reach(from, ZERO_WEIGHT, NO_EDGE);
+  forward.Push(from_potential, from);
+  const Weight to_potential = potential(to);
+  backward.Reach(to, ZERO_WEIGHT, NO_EDGE);
+  backward.Push(-to_potential, to);
+
+  std::optional<Weight> best_weight;
+  VertexId meeting_vertex = from;
+  if (from == to) {
+    best_weight = ZERO_WEIGHT;
+  }
+  SearchStats stats;
+
+  // Вершина, до которой дошли оба поиска, даёт путь; запоминается самый короткий из них
+  auto update_best = [&best_weight, &meeting_vertex, &forward, &backward](VertexId vertex) {
+    const Weight weight = forward.weights[vertex] + backward.weights[vertex];
+    if (!best_weight || weight < *best_weight) {
+      best_weight = weight;
+      meeting_vertex = vertex;
+    }
+  };
+
+  // Шаг поиска в одном направлении. sign = 1 для прямого поиска и -1 для обратного
+  auto step = [this, &potential, &update_best, &stats](SearchState<Weight> &state, const SearchState<Weight> &other,
+                                                       double sign, bool is_forward) {
+    const auto item = state.Pop();
+    if (state.weights[item.vertex] + sign * potential(item.vertex) < item.weight) {
+      return;
+    }
+    ++stats.settled_vertices;
+    auto relax = [&](EdgeId edge_id, VertexId next, Weight edge_weight) {
+      ++stats.relaxed_edges;
+      const Weight candidate_weight = state.weights[item.vertex] + edge_weight;
+      if (!state.IsReached(next) || candidate_weight < state.weights[next]) {
+        const Weight next_potential = potential(next);
+        state.Reach(next, candidate_weight, edge_id);
+        state.Push(candidate_weight + sign * next_potential, next);
+        if (other.IsReached(next)) {
+          update_best(next);
+        }
+      }
+    };
+    if (is_forward) {
+      graph_.ForEachIncidentEdge(item.vertex, relax);
+    } else {
+      for (size_t i = reverse_offsets_[item.vertex], end = reverse_offsets_[item.vertex + 1]; i < end; ++i) {
+        const auto &edge = graph_.GetEdge(reverse_edge_ids_[i]);
+        relax(reverse_edge_ids_[i], edge.from, edge.weight);
+      }
+    }
+  };
+
+  // Сумма ключей в вершинах очередей не меньше веса любого ещё не найденного пути,
+  // поэтому поиск останавливается, как только она достигает веса лучшего найденного
+  while (!forward.queue.empty() && !backward.queue.empty()) {
+    const Weight forward_key = forward.queue.front().weight;
+    const Weight backward_key = backward.queue.front().weight;
+    if (best_weight && !(forward_key + backward_key < *best_weight)) {
+      break;
+    }
+    if (!(backward_key < forward_key)) {
+      step(forward, backward, 1., true);
+    } else {
+      step(backward, forward, -1., false);
+    }
+  }
+
+  if (!best_weight) {
+    return std::nullopt;
+  }
+
+  // Прямой поиск хранит рёбра, ведущие в вершину, обратный — рёбра, выходящие из неё
+  std::vector<EdgeId> edges;
+  for (EdgeId edge_id = forward.prev_edges[meeting_vertex]; edge_id != NO_EDGE;
+       edge_id = forward.prev_edges[graph_.GetEdge(edge_id).from]) {
+    edges.push_back(edge_id);
+  }
+  std::reverse(edges.begin(), edges.end());
+  for (EdgeId edge_id = backward.prev_edges[meeting_vertex]; edge_id != NO_EDGE;
+       edge_id = backward.prev_edges[graph_.GetEdge(edge_id).to]) {
+    edges.push_back(edge_id);
+  }
+
+  return RouteInfo{*best_weight, std::move(edges), stats};
+}
+
+}  // namespace graph
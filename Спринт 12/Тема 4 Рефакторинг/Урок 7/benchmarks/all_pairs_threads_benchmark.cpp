@@ -0,0 +1,87 @@
+/*
+ * Время построения таблицы всех пар graph::Router на 1, 2, 4, ... потоках вплоть до числа ядер
+ * и ускорение относительно одного потока. Граф случайный: каждая вершина соединена рёбрами
+ * со случайными соседями, веса случайные. Таблица на каждом числе потоков проверяется на совпадение
+ * с однопоточной, потому что многопоточное построение обязано давать побитово тот же результат.
+ *
+ * Сборка из каталога урока:
+ *   g++ -std=c++17 -O2 -pthread -I. benchmarks/all_pairs_threads_benchmark.cpp \
+ *       $(ls *.cpp | grep -v '^main.cpp$') -o all_pairs_threads_benchmark
+ * Запуск:
+ *   ./all_pairs_threads_benchmark [число вершин, по умолчанию 2000] [рёбер из вершины, по умолчанию 8]
+ */
+#include "graph.h"
+#include "router.h"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::literals;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+graph::DirectedWeightedGraph<double> MakeRandomGraph(size_t vertex_count, size_t edges_per_vertex) {
+  std::mt19937 random_engine(42);
+  std::uniform_int_distribution<graph::VertexId> vertex(0, static_cast<graph::VertexId>(vertex_count - 1));
+  std::uniform_real_distribution<double> weight(1, 100);
+  graph::DirectedWeightedGraph<double> graph(vertex_count);
+  for (graph::VertexId from = 0; from < vertex_count; ++from) {
+    for (size_t i = 0; i < edges_per_vertex; ++i) {
+      graph.AddEdge({from, vertex(random_engine), weight(random_engine)});
+    }
+  }
+  graph.Freeze();
+  return graph;
+}
+
+// Веса всех маршрутов таблицы построчно, чтобы сравнить таблицы, построенные на разном числе потоков
+std::vector<double> GetRouteWeights(const graph::Router<double> &router, size_t vertex_count) {
+  std::vector<double> weights;
+  weights.reserve(vertex_count * vertex_count);
+  for (graph::VertexId from = 0; from < vertex_count; ++from) {
+    for (graph::VertexId to = 0; to < vertex_count; ++to) {
+      const auto route = router.BuildRoute(from, to);
+      weights.push_back(route ? route->weight : -1);
+    }
+  }
+  return weights;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  const size_t vertex_count = argc > 1 ? std::stoul(argv[1]) : 2000;
+  const size_t edges_per_vertex = argc > 2 ? std::stoul(argv[2]) : 8;
+  if (vertex_count == 0) {
+    std::cerr << "Usage: all_pairs_threads_benchmark [vertex_count] [edges_per_vertex]\n"sv;
+    return 1;
+  }
+  const auto graph = MakeRandomGraph(vertex_count, edges_per_vertex);
+  // Router ограничивает число потоков числом ядер, больше потоков измерять нет смысла
+  const size_t core_count = std::max(std::thread::hardware_concurrency(), 1u);
+  std::cout << vertex_count << " vertices, "sv << graph.GetEdgeCount() << " edges, "sv << core_count
+            << " cores\n"sv;
+
+  double single_thread_ms = 0;
+  std::vector<double> single_thread_weights;
+  for (size_t thread_count = 1; thread_count <= core_count; thread_count *= 2) {
+    const auto start = Clock::now();
+    const graph::Router<double> router(graph, thread_count);
+    const double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    const auto weights = GetRouteWeights(router, vertex_count);
+    if (thread_count == 1) {
+      single_thread_ms = ms;
+      single_thread_weights = weights;
+    }
+    std::cout << thread_count << " threads: "sv << ms << " ms, speedup "sv << single_thread_ms / ms
+              << (weights == single_thread_weights ? ""sv : ", TABLE DIFFERS FROM 1 THREAD"sv) << '\n';
+  }
+  return 0;
+}
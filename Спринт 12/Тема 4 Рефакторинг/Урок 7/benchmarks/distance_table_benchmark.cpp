@@ -0,0 +1,150 @@
+/*
+ * Замеряет то, что зависит от поиска расстояний по дорогам, на базе из JSON-файла в формате входа программы:
+ * первый (не из кэша) вызов GetRouteInfo для всех маршрутов, построение маршрутизатора и сам поиск
+ * расстояний по парам соседних остановок маршрутов. Для сравнения поиск расстояний повторён на прежней схеме
+ * хранения: std::unordered_map с хэшем названий обеих остановок и вторым поиском в обратную сторону.
+ * Каждый замер повторяется на свежем справочнике, выводится медиана.
+ *
+ * Сборка из каталога урока:
+ *   g++ -std=c++17 -O2 -pthread -I. benchmarks/distance_table_benchmark.cpp \
+ *       $(ls *.cpp | grep -v '^main.cpp$') -o distance_table_benchmark
+ * Запуск:
+ *   ./distance_table_benchmark base.json [число повторов, по умолчанию 11]
+ */
+#include "json_reader.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace std::literals;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using StopPair = std::pair<const tc::Stop *, const tc::Stop *>;
+
+// Прежний хэш пары остановок: строковые хэши обоих названий при каждом поиске
+struct NameStopsPairHasher {
+  size_t operator()(const StopPair &stops) const {
+    const std::hash<std::string> hasher;
+    return hasher(std::string(stops.first->name_)) * 37 + hasher(std::string(stops.second->name_));
+  }
+};
+
+// Прежний поиск расстояния: прямое направление, а если его нет — второй поиск в обратном
+class NameDistanceMap {
+ public:
+  explicit NameDistanceMap(const tc::TransportCatalogue &catalogue) {
+    catalogue.ForEachDistance([this](const tc::Stop *from, const tc::Stop *to, size_t distance) {
+      distances_[{from, to}] = distance;
+    });
+  }
+
+  size_t Get(const StopPair &stops) const {
+    if (const auto it = distances_.find(stops); it != distances_.end()) {
+      return it->second;
+    }
+    if (const auto it = distances_.find({stops.second, stops.first}); it != distances_.end()) {
+      return it->second;
+    }
+    return 0;
+  }
+
+ private:
+  std::unordered_map<StopPair, size_t, NameStopsPairHasher> distances_;
+};
+
+double ToMilliseconds(Clock::duration duration) {
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+double Median(std::vector<double> values) {
+  std::sort(values.begin(), values.end());
+  return values.empty() ? 0 : values[values.size() / 2];
+}
+
+// Пары соседних остановок всех маршрутов — то, что ищут GetRouteInfo и построение графа
+std::vector<StopPair> CollectStopPairs(const tc::TransportCatalogue &catalogue) {
+  std::vector<StopPair> pairs;
+  for (const tc::Route *route : catalogue.GetAllRoutes()) {
+    for (size_t i = 1; i < route->stops_.size(); ++i) {
+      pairs.emplace_back(route->stops_[i - 1], route->stops_[i]);
+    }
+  }
+  return pairs;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  if (argc < 2 || argc > 3) {
+    std::cerr << "Usage: distance_table_benchmark base.json [repeat_count]\n"sv;
+    return 1;
+  }
+  const size_t repeat_count = argc == 3 ? std::stoul(argv[2]) : 11;
+
+  std::ifstream input(argv[1]);
+  JsonReader reader;
+  reader.ParseStream(input);
+  router::Params params = reader.FillRouterSettings();
+  params.mode = router::RoutingMode::Dijkstra;
+  params.route_cache_capacity = 0;
+
+  std::vector<double> route_info_ms;
+  std::vector<double> router_build_ms;
+  std::vector<double> table_lookup_ms;
+  std::vector<double> map_lookup_ms;
+  size_t checksum = 0;  // Чтобы компилятор не выбросил замеряемые вызовы
+  size_t route_count = 0;
+  size_t pair_count = 0;
+  for (size_t repeat = 0; repeat < repeat_count; ++repeat) {
+    tc::TransportCatalogue catalogue;
+    reader.FillCatalogue(catalogue);
+    const auto routes = catalogue.GetAllRoutes();
+    const auto pairs = CollectStopPairs(catalogue);
+    route_count = routes.size();
+    pair_count = pairs.size();
+
+    auto start = Clock::now();
+    for (const tc::Route *route : routes) {
+      checksum += catalogue.GetRouteInfo(route->name_).real_length_;
+    }
+    route_info_ms.push_back(ToMilliseconds(Clock::now() - start));
+
+    start = Clock::now();
+    {
+      const router::Router transport_router(params, catalogue);
+    }
+    router_build_ms.push_back(ToMilliseconds(Clock::now() - start));
+
+    start = Clock::now();
+    for (const auto &stops : pairs) {
+      checksum += catalogue.GetDistance(stops);
+    }
+    table_lookup_ms.push_back(ToMilliseconds(Clock::now() - start));
+
+    const NameDistanceMap name_distances(catalogue);
+    start = Clock::now();
+    for (const auto &stops : pairs) {
+      checksum -= name_distances.Get(stops);
+    }
+    map_lookup_ms.push_back(ToMilliseconds(Clock::now() - start));
+  }
+
+  std::cout << route_count << " routes, "sv << pair_count << " stop pairs, "sv << repeat_count << " repeats\n"sv
+            << "GetRouteInfo, all routes: "sv << Median(route_info_ms) << " ms\n"sv
+            << "router construction: "sv << Median(router_build_ms) << " ms\n"sv
+            << "distance lookups, DistanceTable: "sv << Median(table_lookup_ms) << " ms\n"sv
+            << "distance lookups, name-hashed map: "sv << Median(map_lookup_ms) << " ms\n"sv
+            << "(checksum "sv << checksum << ")\n"sv;
+  return 0;
+}
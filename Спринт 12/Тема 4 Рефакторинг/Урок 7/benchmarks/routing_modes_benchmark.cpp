@@ -0,0 +1,113 @@
+/*
+ * Сравнивает режимы маршрутизации all_pairs и dijkstra на базе из JSON-файла в формате входа программы:
+ * время построения маршрутизатора, прирост резидентной памяти при построении и задержку ответа
+ * на запрос маршрута (p50, p99) на одних и тех же случайных парах остановок. Кэш маршрутов выключен.
+ *
+ * Сборка из каталога урока:
+ *   g++ -std=c++17 -O2 -pthread -I. benchmarks/routing_modes_benchmark.cpp \
+ *       $(ls *.cpp | grep -v '^main.cpp$') -o routing_modes_benchmark
+ * Запуск:
+ *   ./routing_modes_benchmark base.json [число запросов, по умолчанию 10000]
+ */
+#include "json_reader.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace std::literals;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Текущий размер резидентной памяти процесса в килобайтах (Linux)
+long GetResidentKilobytes() {
+  std::ifstream statm("/proc/self/statm");
+  long total_pages = 0;
+  long resident_pages = 0;
+  statm >> total_pages >> resident_pages;
+  return resident_pages * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+double ToMicroseconds(Clock::duration duration) {
+  return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+void RunMode(std::string_view name, router::Params params, const tc::TransportCatalogue &catalogue,
+             const std::vector<std::pair<std::string_view, std::string_view>> &queries) {
+  params.route_cache_capacity = 0;
+  const long resident_before = GetResidentKilobytes();
+  const auto build_start = Clock::now();
+  const router::Router transport_router(params, catalogue);
+  const double build_ms = ToMicroseconds(Clock::now() - build_start) / 1000;
+  const long resident_after = GetResidentKilobytes();
+
+  std::vector<double> latencies;
+  latencies.reserve(queries.size());
+  double total_time = 0;  // Чтобы компилятор не выбросил поиск
+  size_t not_found_count = 0;
+  for (const auto &[from, to] : queries) {
+    const auto query_start = Clock::now();
+    try {
+      total_time += transport_router.FindRoute(from, to).total_time.count();
+    } catch (const router::GraphError &) {
+      ++not_found_count;
+    }
+    latencies.push_back(ToMicroseconds(Clock::now() - query_start));
+  }
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&latencies](double p) {
+    return latencies.empty() ? 0 : latencies[static_cast<size_t>(p * static_cast<double>(latencies.size() - 1))];
+  };
+
+  std::cout << name << ": build "sv << build_ms << " ms, resident memory +"sv
+            << resident_after - resident_before << " kB, query p50 "sv << percentile(0.5) << " us, p99 "sv
+            << percentile(0.99) << " us, not found "sv << not_found_count << " (checksum "sv << total_time
+            << ")\n"sv;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  if (argc < 2 || argc > 3) {
+    std::cerr << "Usage: routing_modes_benchmark base.json [query_count]\n"sv;
+    return 1;
+  }
+  const size_t query_count = argc == 3 ? std::stoul(argv[2]) : 10000;
+
+  std::ifstream input(argv[1]);
+  JsonReader reader;
+  reader.ParseStream(input);
+  tc::TransportCatalogue catalogue;
+  reader.FillCatalogue(catalogue);
+
+  const auto stops = catalogue.GetSortedAllNonEmptyStops();
+  if (stops.empty()) {
+    std::cerr << "No stops with routes in the base\n"sv;
+    return 1;
+  }
+  std::mt19937 random_engine(42);
+  std::uniform_int_distribution<size_t> stop_index(0, stops.size() - 1);
+  std::vector<std::pair<std::string_view, std::string_view>> queries;
+  queries.reserve(query_count);
+  for (size_t i = 0; i < query_count; ++i) {
+    queries.emplace_back(stops[stop_index(random_engine)]->name_, stops[stop_index(random_engine)]->name_);
+  }
+  std::cout << catalogue.GetStopCount() << " stops, "sv << catalogue.GetRouteCount() << " routes, "sv
+            << queries.size() << " queries\n"sv;
+
+  router::Params params = reader.FillRouterSettings();
+  params.mode = router::RoutingMode::Dijkstra;
+  RunMode("dijkstra"sv, params, catalogue, queries);
+  params.mode = router::RoutingMode::AllPairs;
+  RunMode("all_pairs"sv, params, catalogue, queries);
+  return 0;
+}
@@ -0,0 +1,128 @@
+#include "connection_scan.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+using namespace router;
+
+ConnectionScanRouter::ConnectionScanRouter(const tc::TransportCatalogue &catalogue, double default_headway,
+                                           double bus_velocity)
+    : stops_(catalogue.GetAllStops()) {
+  const auto routes = catalogue.GetSortedAllNonEmptyRoutes();
+  auto get_headway = [default_headway](const tc::Route *route) {
+    return route->schedule_.headway_ > 0 ? route->schedule_.headway_ : default_headway;
+  };
+  // Проверка до построения, чтобы ошибка не стоила построения части связей
+  for (const tc::Route *route : routes) {
+    if (route->stops_.size() > 1 && !(get_headway(route) > 0)) {
+      throw std::invalid_argument("Headway of route " + std::string(route->name_) + " should be positive");
+    }
+  }
+
+  const double meters_per_minute = bus_velocity * 1000 / 60.0;
+  std::vector<double> stop_offsets;
+  for (const tc::Route *route : routes) {
+    const auto &route_stops = route->stops_;
+    if (route_stops.size() <= 1) {
+      continue;
+    }
+    const auto &schedule = route->schedule_;
+    const double headway = get_headway(route);
+
+    // Время в пути от начальной остановки до каждой остановки маршрута одинаково для всех рейсов
+    stop_offsets.assign(1, 0.);
+    for (size_t i = 0; i + 1 < route_stops.size(); ++i) {
+      stop_offsets.push_back(stop_offsets.back()
+                                 + catalogue.GetDistance({route_stops[i], route_stops[i + 1]}) / meters_per_minute);
+    }
+
+    // Время отправления считается от первого рейса, а не прибавлением интервала, чтобы не копить ошибку округления
+    for (size_t k = 0;; ++k) {
+      const double start = schedule.first_departure_ + static_cast<double>(k) * headway;
+      if (start > schedule.last_departure_) {
+        break;
+      }
+      const auto trip = static_cast<uint32_t>(trip_routes_.size());
+      trip_routes_.push_back(route);
+      for (size_t i = 0; i + 1 < route_stops.size(); ++i) {
+        connections_.push_back({start + stop_offsets[i], start + stop_offsets[i + 1],
+                                route_stops[i]->id_, route_stops[i + 1]->id_, trip, static_cast<uint32_t>(i)});
+      }
+    }
+  }
+  if (connections_.size() >= NONE || trip_routes_.size() >= NONE) {
+    throw std::length_error("Too many connections in the timetable");
+  }
+
+  // Перегоны нулевой длины прибывают в момент отправления, поэтому при равном отправлении
+  // раньше идут связи, которые раньше прибывают. Устойчивая сортировка сохраняет порядок перегонов рейса
+  std::stable_sort(connections_.begin(), connections_.end(), [](const Connection &lhs, const Connection &rhs) {
+    return lhs.departure_time < rhs.departure_time
+        || (lhs.departure_time == rhs.departure_time && lhs.arrival_time < rhs.arrival_time);
+  });
+}
+
+size_t ConnectionScanRouter::GetConnectionCount() const {
+  return connections_.size();
+}
+
+std::optional<ConnectionScanRouter::Journey> ConnectionScanRouter::FindJourney(const tc::Stop *from,
+                                                                              const tc::Stop *to,
+                                                                              double departure_time) const {
+  const uint32_t source = from->id_;
+  const uint32_t target = to->id_;
+  if (source == target) {
+    // Как и в графе маршрутизатора, остановка без маршрутов недостижима даже из самой себя
+    if (from->routes_.empty()) {
+      return std::nullopt;
+    }
+    return Journey{departure_time, {}};
+  }
+
+  thread_local ScanState state;
+  state.Prepare(stops_.size(), trip_routes_.size());
+  state.SetArrival(source, departure_time, NONE);
+
+  const auto first = std::lower_bound(connections_.begin(), connections_.end(), departure_time,
+                                      [](const Connection &connection, double time) {
+                                        return connection.departure_time < time;
+                                      });
+  for (auto it = first; it != connections_.end(); ++it) {
+    const Connection &connection = *it;
+    // Все следующие связи отправляются не раньше, а значит, и прибывают не раньше уже найденного
+    if (!(connection.departure_time < state.GetArrivalTime(target))) {
+      break;
+    }
+    const auto index = static_cast<uint32_t>(it - connections_.begin());
+    if (state.GetBoarding(connection.trip) == NONE) {
+      if (state.GetArrivalTime(connection.from_stop) > connection.departure_time) {
+        continue;
+      }
+      state.SetBoarding(connection.trip, index);
+    }
+    if (connection.arrival_time < state.GetArrivalTime(connection.to_stop)) {
+      state.SetArrival(connection.to_stop, connection.arrival_time, index);
+    }
+  }
+  if (state.GetArrivalConnection(target) == NONE) {
+    return std::nullopt;
+  }
+
+  // Путь восстанавливается с конца: связь, которой приехали на остановку, и связь, на которой сели в тот же рейс
+  Journey journey{state.GetArrivalTime(target), {}};
+  for (uint32_t stop = target; stop != source;) {
+    const Connection &exit = connections_[state.GetArrivalConnection(stop)];
+    const Connection &enter = connections_[state.GetBoarding(exit.trip)];
+    journey.legs.push_back({
+        trip_routes_[exit.trip],
+        stops_[enter.from_stop],
+        enter.departure_time - state.GetArrivalTime(enter.from_stop),
+        exit.arrival_time - enter.departure_time,
+        static_cast<size_t>(exit.trip_position - enter.trip_position + 1),
+    });
+    stop = enter.from_stop;
+  }
+  std::reverse(journey.legs.begin(), journey.legs.end());
+  return journey;
+}
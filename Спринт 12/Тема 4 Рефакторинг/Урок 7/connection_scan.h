@@ -0,0 +1,121 @@
+#pragma once
+
+#include "domain.h"
+#include "transport_catalogue.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+namespace router {
+
+/*
+ * Поиск маршрутов по расписанию алгоритмом сканирования связей (Connection Scan Algorithm).
+ * Каждый рейс каждого автобуса раскладывается на связи — перегоны между соседними остановками с временем
+ * отправления и прибытия. Связи лежат в одном массиве, отсортированном по времени отправления, и запрос
+ * просматривает его один раз подряд, начиная с момента отправления, пока не станет ясно, что раньше
+ * до цели уже не добраться. Память O(число связей), время запроса O(просмотренных связей).
+ * Время везде в минутах от начала суток
+ */
+class ConnectionScanRouter {
+ public:
+  // Участок пути: ожидание на остановке посадки и поездка на одном рейсе
+  struct Leg {
+    const tc::Route *route;
+    const tc::Stop *boarding_stop;
+    double wait_time;
+    double ride_time;
+    size_t steps_count;
+  };
+
+  struct Journey {
+    double arrival_time;
+    std::vector<Leg> legs;
+  };
+
+  /**
+   * Строит связи по расписаниям маршрутов справочника. Маршруты без своего расписания ходят весь день
+   * с интервалом default_headway. Время поездки по перегону — расстояние, делённое на bus_velocity (км/ч).
+   * Если у маршрута нет положительного интервала, std::invalid_argument до построения связей
+   */
+  ConnectionScanRouter(const tc::TransportCatalogue &catalogue, double default_headway, double bus_velocity);
+
+  // Самый ранний приезд в to при отправлении из from не раньше departure_time, std::nullopt — если не успеть
+  std::optional<Journey> FindJourney(const tc::Stop *from, const tc::Stop *to, double departure_time) const;
+
+  size_t GetConnectionCount() const;
+
+ private:
+  static constexpr uint32_t NONE = static_cast<uint32_t>(-1);
+
+  struct Connection {
+    double departure_time;
+    double arrival_time;
+    uint32_t from_stop;
+    uint32_t to_stop;
+    uint32_t trip;
+    uint32_t trip_position;  // Номер перегона в рейсе
+  };
+
+  // Рабочие массивы запроса, переиспользуются между запросами одного потока. Как в graph::SearchState,
+  // массивы не очищаются: остановка или рейс учитываются, только если помечены номером текущего запроса
+  struct ScanState {
+    std::vector<double> arrival_times;
+    std::vector<uint32_t> arrival_connections;
+    std::vector<uint32_t> stop_marks;
+    std::vector<uint32_t> trip_boardings;
+    std::vector<uint32_t> trip_marks;
+    uint32_t current_mark = 0;
+
+    void Prepare(size_t stop_count, size_t trip_count) {
+      if (stop_marks.size() < stop_count) {
+        arrival_times.resize(stop_count);
+        arrival_connections.resize(stop_count);
+        stop_marks.resize(stop_count, 0);
+      }
+      if (trip_marks.size() < trip_count) {
+        trip_boardings.resize(trip_count);
+        trip_marks.resize(trip_count, 0);
+      }
+      if (++current_mark == 0) {
+        // Счётчик переполнился, старые метки больше нельзя отличить от новых
+        std::fill(stop_marks.begin(), stop_marks.end(), 0);
+        std::fill(trip_marks.begin(), trip_marks.end(), 0);
+        current_mark = 1;
+      }
+    }
+
+    double GetArrivalTime(uint32_t stop) const {
+      return stop_marks[stop] == current_mark ? arrival_times[stop] : std::numeric_limits<double>::infinity();
+    }
+
+    // Связь, которой приехали на остановку, NONE — если остановка начальная или не достигнута
+    uint32_t GetArrivalConnection(uint32_t stop) const {
+      return stop_marks[stop] == current_mark ? arrival_connections[stop] : NONE;
+    }
+
+    void SetArrival(uint32_t stop, double time, uint32_t connection) {
+      stop_marks[stop] = current_mark;
+      arrival_times[stop] = time;
+      arrival_connections[stop] = connection;
+    }
+
+    // Связь, на которой сели в рейс, NONE — если в рейс не садились
+    uint32_t GetBoarding(uint32_t trip) const {
+      return trip_marks[trip] == current_mark ? trip_boardings[trip] : NONE;
+    }
+
+    void SetBoarding(uint32_t trip, uint32_t connection) {
+      trip_marks[trip] = current_mark;
+      trip_boardings[trip] = connection;
+    }
+  };
+
+  std::vector<Connection> connections_;
+  std::vector<const tc::Route *> trip_routes_;
+  std::vector<const tc::Stop *> stops_;  // Все остановки справочника по номерам
+};
+
+}  // namespace router
@@ -0,0 +1,476 @@
+#pragma once
+
+#include "dijkstra_router.h"
+#include "graph.h"
+#include "router.h"
+#include "snapshot.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+/*
+ * Маршрутизатор на иерархиях сжатия (contraction hierarchies).
+ * При построении вершины по очереди «стягиваются»: вершина удаляется из графа, а кратчайшие пути через неё
+ * заменяются рёбрами-сокращениями между её соседями. Номер вершины в порядке стягивания называется её рангом.
+ * Запрос — двунаправленный поиск Дейкстры, где прямой поиск идёт только по рёбрам к вершинам большего ранга,
+ * а обратный — только по рёбрам из вершин большего ранга. Найденный путь раскрывается обратно в рёбра исходного графа.
+ * Память линейна по размеру графа и числу сокращений, а запрос просматривает лишь малую часть вершин.
+ * Слишком плотный остаток графа не стягивается (см. CORE_DEGREE_LIMIT)
+ */
+template<typename Weight>
+class ContractionHierarchyRouter : public RouterBase<Weight> {
+ private:
+  using Graph = DirectedWeightedGraph<Weight>;
+
+ public:
+  using typename RouterBase<Weight>::RouteInfo;
+
+  explicit ContractionHierarchyRouter(const Graph &graph);
+
+  // Восстанавливает иерархию, сохранённую методом Save, не стягивая вершины заново
+  ContractionHierarchyRouter(const Graph &graph, serialization::Reader &reader);
+
+  std::optional <RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+  void Save(serialization::Writer &writer) const override;
+
+ private:
+  // Ребро-сокращение заменяет путь из двух рёбер: first_child ведёт в стянутую вершину, second_child — из неё.
+  // Номера рёбер-сокращений продолжают нумерацию рёбер исходного графа
+  struct Shortcut {
+    VertexId from;
+    VertexId to;
+    Weight weight;
+    EdgeId first_child;
+    EdgeId second_child;
+  };
+
+  struct Arc {
+    VertexId to;
+    Weight weight;
+    EdgeId edge_id;
+  };
+
+  // Ребро графа, который остаётся после стягивания части вершин. other — второй конец ребра
+  struct WorkingEdge {
+    VertexId other;
+    Weight weight;
+    EdgeId edge_id;
+  };
+
+  // Состояние процесса стягивания, нужно только во время построения
+  struct ContractionState {
+    std::vector<std::vector<WorkingEdge>> out_edges;
+    std::vector<std::vector<WorkingEdge>> in_edges;
+    std::vector<bool> is_contracted;
+    std::vector<size_t> contracted_neighbours;
+  };
+
+  void Contract();
+  void FindShortcuts(const ContractionState &state, VertexId vertex, size_t settle_limit,
+                     std::vector<Shortcut> &shortcuts) const;
+  void RunWitnessSearch(const ContractionState &state, VertexId source, VertexId excluded, Weight max_weight,
+                        size_t settle_limit) const;
+  int ComputePriority(const ContractionState &state, VertexId vertex, std::vector<Shortcut> &shortcuts) const;
+  static void AddWorkingEdge(ContractionState &state, VertexId from, VertexId to, Weight weight, EdgeId edge_id);
+
+  void BuildSearchGraphs();
+  VertexId GetEdgeSource(EdgeId edge_id) const;
+  VertexId GetEdgeTarget(EdgeId edge_id) const;
+  void UnpackEdge(EdgeId edge_id, std::vector<EdgeId> &edges) const;
+
+  // Сколько вершин может просмотреть поиск свидетеля, прежде чем сдаться и добавить сокращение.
+  // Лишнее сокращение не ломает ответы, а лишь немного увеличивает иерархию, поэтому для оценки
+  // приоритета, которая повторяется много раз, хватает короткого поиска
+  static constexpr size_t PRIORITY_SETTLE_LIMIT = 10;
+  static constexpr size_t CONTRACTION_SETTLE_LIMIT = 100;
+  // Стягивание останавливается, когда даже у лучшей вершины больше рёбер, чем этот предел. В графах с длинными
+  // маршрутами остаток быстро становится плотным, и его стягивание стоит квадратично по числу вершин.
+  // Оставшиеся вершины образуют ядро, по которому поиск при запросе идёт без ограничений на ранг
+  static constexpr size_t CORE_DEGREE_LIMIT = 48;
+  static constexpr Weight ZERO_WEIGHT{};
+  static constexpr EdgeId NO_EDGE = SearchState<Weight>::NO_EDGE;
+
+  const Graph &graph_;
+  std::vector<uint32_t> ranks_;
+  std::vector<Shortcut> shortcuts_;
+
+  // Графы для запросов в CSR-представлении: рёбра вверх по рангу из каждой вершины
+  // и рёбра, входящие в каждую вершину сверху
+  std::vector<size_t> up_offsets_;
+  std::vector<Arc> up_arcs_;
+  std::vector<size_t> down_offsets_;
+  std::vector<Arc> down_arcs_;
+};
+
+template<typename Weight>
+ContractionHierarchyRouter<Weight>::ContractionHierarchyRouter(const Graph &graph)
+    : graph_(graph) {
+  for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+    if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+      throw std::domain_error("Edges' weights should be non-negative");
+    }
+  }
+  Contract();
+  BuildSearchGraphs();
+}
+
+template<typename Weight>
+ContractionHierarchyRouter<Weight>::ContractionHierarchyRouter(const Graph &graph, serialization::Reader &reader)
+    : graph_(graph) {
+  const auto ranks = reader.ReadArray<uint32_t>();
+  ranks_.assign(ranks.begin(), ranks.end());
+  const auto shortcuts = reader.ReadArray<Shortcut>();
+  shortcuts_.assign(shortcuts.begin(), shortcuts.end());
+  if (ranks_.size() != graph.GetVertexCount()) {
+    throw serialization::SnapshotError("Contraction hierarchy doesn't match the graph");
+  }
+  BuildSearchGraphs();
+}
+
+template<typename Weight>
+void ContractionHierarchyRouter<Weight>::AddWorkingEdge(ContractionState &state, VertexId from, VertexId to,
+                                                        Weight weight, EdgeId edge_id) {
+  // Из параллельных рёбер достаточно хранить самое короткое
+  auto &out_edges = state.out_edges[from];
+  const auto it = std::find_if(out_edges.begin(), out_edges.end(),
+                               [to](const WorkingEdge &edge) { return edge.other == to; });
+  if (it == out_edges.end()) {
+    out_edges.push_back({to, weight, edge_id});
+    state.in_edges[to].push_back({from, weight, edge_id});
+    return;
+  }
+  if (weight < it->weight) {
+    *it = {to, weight, edge_id};
+    auto &in_edges = state.in_edges[to];
+    *std::find_if(in_edges.begin(), in_edges.end(),
+                  [from](const WorkingEdge &edge) { return edge.other == from; }) = {from, weight, edge_id};
+  }
+}
+
+template<typename Weight>
+void ContractionHierarchyRouter<Weight>::RunWitnessSearch(const ContractionState &state, VertexId source,
+                                                          VertexId excluded, Weight max_weight,
+                                                          size_t settle_limit) const {
+  auto &search = SearchState<Weight>::ForCurrentThread();
+  search.Prepare(graph_.GetVertexCount());
+  search.Reach(source, ZERO_WEIGHT, NO_EDGE);
+  search.Push(ZERO_WEIGHT, source);
+  size_t settled_count = 0;
+  while (!search.queue.empty() && settled_count < settle_limit) {
+    const auto item = search.Pop();
+    if (search.IsStale(item)) {
+      continue;
+    }
+    if (max_weight < item.weight) {
+      break;
+    }
+    ++settled_count;
+    for (const auto &edge : state.out_edges[item.vertex]) {
+      if (edge.other == excluded) {
+        continue;
+      }
+      const Weight candidate_weight = item.weight + edge.weight;
+      if (!search.IsReached(edge.other) || candidate_weight < search.weights[edge.other]) {
+        search.Reach(edge.other, candidate_weight, edge.edge_id);
+        search.Push(candidate_weight, edge.other);
+      }
+    }
+  }
+}
+
+template<typename Weight>
+void ContractionHierarchyRouter<Weight>::FindShortcuts(const ContractionState &state, VertexId vertex,
+                                                       size_t settle_limit, std::vector<Shortcut> &shortcuts) const {
+  shortcuts.clear();
+  for (const auto &in_edge : state.in_edges[vertex]) {
+    const VertexId from = in_edge.other;
+    if (from == vertex) {
+      continue;
+    }
+    std::optional<Weight> max_weight;
+    for (const auto &out_edge : state.out_edges[vertex]) {
+      const VertexId to = out_edge.other;
+      if (to != vertex && to != from) {
+        const Weight weight = in_edge.weight + out_edge.weight;
+        max_weight = max_weight ? std::max(*max_weight, weight) : weight;
+      }
+    }
+    if (!max_weight) {
+      continue;
+    }
+
+    // Сокращение нужно, только если без стягиваемой вершины не нашлось пути («свидетеля») не длиннее
+    RunWitnessSearch(state, from, vertex, *max_weight, settle_limit);
+    const auto &search = SearchState<Weight>::ForCurrentThread();
+    for (const auto &out_edge : state.out_edges[vertex]) {
+      const VertexId to = out_edge.other;
+      if (to == vertex || to == from) {
+        continue;
+      }
+      const Weight weight = in_edge.weight + out_edge.weight;
+      if (!search.IsReached(to) || weight < search.weights[to]) {
+        shortcuts.push_back({from, to, weight, in_edge.edge_id, out_edge.edge_id});
+      }
+    }
+  }
+}
+
+template<typename Weight>
+int ContractionHierarchyRouter<Weight>::ComputePriority(const ContractionState &state, VertexId vertex,
+                                                        std::vector<Shortcut> &shortcuts) const {
+  // Сначала стягиваются вершины, которые добавляют мало сокращений и убирают много рёбер,
+  // а соседи уже стянутых вершин откладываются, чтобы стягивание шло по графу равномерно
+  FindShortcuts(state, vertex, PRIORITY_SETTLE_LIMIT, shortcuts);
+  const size_t removed_count = state.in_edges[vertex].size() + state.out_edges[vertex].size();
+  return static_cast<int>(shortcuts.size()) - static_cast<int>(removed_count)
+      + static_cast<int>(state.contracted_neighbours[vertex]);
+}
+
+template<typename Weight>
+void ContractionHierarchyRouter<Weight>::Contract() {
+  const size_t vertex_count = graph_.GetVertexCount();
+  const EdgeId edge_count = graph_.GetEdgeCount();
+  ContractionState state{
+      std::vector<std::vector<WorkingEdge>>(vertex_count),
+      std::vector<std::vector<WorkingEdge>>(vertex_count),
+      std::vector<bool>(vertex_count, false),
+      std::vector<size_t>(vertex_count, 0),
+  };
+  for (EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+    const auto &edge = graph_.GetEdge(edge_id);
+    if (edge.from != edge.to) {
+      AddWorkingEdge(state, edge.from, edge.to, edge.weight, edge_id);
+    }
+  }
+
+  using QueueItem = std::pair<int, VertexId>;
+  std::vector<QueueItem> queue;
+  std::vector<Shortcut> shortcuts;
+  queue.reserve(vertex_count);
+  for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+    queue.emplace_back(ComputePriority(state, vertex, shortcuts), vertex);
+  }
+  std::make_heap(queue.begin(), queue.end(), std::greater<>{});
+
+  ranks_.assign(vertex_count, 0);
+  uint32_t next_rank = 0;
+  while (!queue.empty()) {
+    std::pop_heap(queue.begin(), queue.end(), std::greater<>{});
+    const VertexId vertex = queue.back().second;
+    queue.pop_back();
+
+    // Приоритеты соседей меняются по мере стягивания, поэтому перед стягиванием приоритет пересчитывается:
+    // если вершина перестала быть лучшей, она возвращается в очередь
+    const int priority = ComputePriority(state, vertex, shortcuts);
+    if (!queue.empty() && queue.front().first < priority) {
+      queue.emplace_back(priority, vertex);
+      std::push_heap(queue.begin(), queue.end(), std::greater<>{});
+      continue;
+    }
+    if (state.in_edges[vertex].size() + state.out_edges[vertex].size() > CORE_DEGREE_LIMIT) {
+      break;
+    }
+
+    FindShortcuts(state, vertex, CONTRACTION_SETTLE_LIMIT, shortcuts);
+    for (auto shortcut : shortcuts) {
+      const EdgeId shortcut_id = edge_count + shortcuts_.size();
+      shortcuts_.push_back(shortcut);
+      AddWorkingEdge(state, shortcut.from, shortcut.to, shortcut.weight, shortcut_id);
+    }
+    state.is_contracted[vertex] = true;
+    ranks_[vertex] = next_rank++;
+    // Рёбра стянутой вершины больше не понадобятся: они удаляются и у соседей, чтобы поиски свидетелей
+    // не просматривали их снова
+    auto erase_edges_to = [vertex](std::vector<WorkingEdge> &edges) {
+      edges.erase(std::remove_if(edges.begin(), edges.end(),
+                                 [vertex](const WorkingEdge &edge) { return edge.other == vertex; }),
+                  edges.end());
+    };
+    for (const auto &edge : state.in_edges[vertex]) {
+      ++state.contracted_neighbours[edge.other];
+      erase_edges_to(state.out_edges[edge.other]);
+    }
+    for (const auto &edge : state.out_edges[vertex]) {
+      ++state.contracted_neighbours[edge.other];
+      erase_edges_to(state.in_edges[edge.other]);
+    }
+    std::vector<WorkingEdge>().swap(state.in_edges[vertex]);
+    std::vector<WorkingEdge>().swap(state.out_edges[vertex]);
+  }
+
+  // Оставшиеся вершины образуют ядро с общим рангом: рёбра между ними попадают в оба графа поиска
+  for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+    if (!state.is_contracted[vertex]) {
+      ranks_[vertex] = next_rank;
+    }
+  }
+}
+
+template<typename Weight>
+void ContractionHierarchyRouter<Weight>::BuildSearchGraphs() {
+  const size_t vertex_count = graph_.GetVertexCount();
+  const EdgeId edge_count = graph_.GetEdgeCount();
+  std::vector<std::vector<Arc>> up(vertex_count);
+  std::vector<std::vector<Arc>> down(vertex_count);
+  auto add_edge = [this, &up, &down](VertexId from, VertexId to, Weight weight, EdgeId edge_id) {
+    if (from == to) {
+      return;
+    }
+    if (ranks_[from] <= ranks_[to]) {
+      up[from].push_back({to, weight, edge_id});
+    }
+    if (ranks_[to] <= ranks_[from]) {
+      down[to].push_back({from, weight, edge_id});
+    }
+  };
+  for (EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+    const auto &edge = graph_.GetEdge(edge_id);
+    add_edge(edge.from, edge.to, edge.weight, edge_id);
+  }
+  for (size_t i = 0; i < shortcuts_.size(); ++i) {
+    add_edge(shortcuts_[i].from, shortcuts_[i].to, shortcuts_[i].weight, edge_count + i);
+  }
+
+  auto pack = [vertex_count](const std::vector<std::vector<Arc>> &lists, std::vector<size_t> &offsets,
+                             std::vector<Arc> &arcs) {
+    offsets.assign(vertex_count + 1, 0);
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+      arcs.insert(arcs.end(), lists[vertex].begin(), lists[vertex].end());
+      offsets[vertex + 1] = arcs.size();
+    }
+  };
+  pack(up, up_offsets_, up_arcs_);
+  pack(down, down_offsets_, down_arcs_);
+}
+
+template<typename Weight>
+VertexId ContractionHierarchyRouter<Weight>::GetEdgeSource(EdgeId edge_id) const {
+  const EdgeId edge_count = graph_.GetEdgeCount();
+  return edge_id < edge_count ? graph_.GetEdge(edge_id).from : shortcuts_[edge_id - edge_count].from;
+}
+
+template<typename Weight>
+VertexId ContractionHierarchyRouter<Weight>::GetEdgeTarget(EdgeId edge_id) const {
+  const EdgeId edge_count = graph_.GetEdgeCount();
+  return edge_id < edge_count ? graph_.GetEdge(edge_id).to : shortcuts_[edge_id - edge_count].to;
+}
+
+template<typename Weight>
+void ContractionHierarchyRouter<Weight>::UnpackEdge(EdgeId edge_id, std::vector<EdgeId> &edges) const {
+  const EdgeId edge_count = graph_.GetEdgeCount();
+  std::vector<EdgeId> stack{edge_id};
+  while (!stack.empty()) {
+    const EdgeId current = stack.back();
+    stack.pop_back();
+    if (current < edge_count) {
+      edges.push_back(current);
+    } else {
+      const auto &shortcut = shortcuts_[current - edge_count];
+      stack.push_back(shortcut.second_child);
+      stack.push_back(shortcut.first_child);
+    }
+  }
+}
+
+template<typename Weight>
+std::optional<typename ContractionHierarchyRouter<Weight>::RouteInfo>
+ContractionHierarchyRouter<Weight>::BuildRoute(VertexId from, VertexId to) const {
+  const size_t vertex_count = graph_.GetVertexCount();
+  if (from >= vertex_count || to >= vertex_count) {
+    throw std::out_of_range("Vertex id is out of range");
+  }
+
+  auto &forward = SearchState<Weight>::ForCurrentThread(SearchDirection::Forward);
+  auto &backward = SearchState<Weight>::ForCurrentThread(SearchDirection::Backward);
+  forward.Prepare(vertex_count);
+  backward.Prepare(vertex_count);
+  forward.Reach(from, ZERO_WEIGHT, NO_EDGE);
+  forward.Push(ZERO_WEIGHT, from);
+  backward.Reach(to, ZERO_WEIGHT, NO_EDGE);
+  backward.Push(ZERO_WEIGHT, to);
+
+  std::optional<Weight> best_weight;
+  VertexId meeting_vertex = from;
+  SearchStats stats;
+
+  // Шаг поиска в одном направлении. Направление заканчивает работу, как только его очередь
+  // не может дать путь короче уже найденного
+  auto step = [&best_weight, &meeting_vertex, &stats](SearchState<Weight> &state, const SearchState<Weight> &other,
+                                                      const std::vector<size_t> &offsets,
+                                                      const std::vector<Arc> &arcs) {
+    const auto item = state.Pop();
+    if (state.IsStale(item)) {
+      return;
+    }
+    if (best_weight && !(item.weight < *best_weight)) {
+      state.queue.clear();
+      return;
+    }
+    ++stats.settled_vertices;
+    if (other.IsReached(item.vertex)) {
+      const Weight weight = item.weight + other.weights[item.vertex];
+      if (!best_weight || weight < *best_weight) {
+        best_weight = weight;
+        meeting_vertex = item.vertex;
+      }
+    }
+    for (size_t i = offsets[item.vertex], end = offsets[item.vertex + 1]; i < end; ++i) {
+      ++stats.relaxed_edges;
+      const Arc &arc = arcs[i];
+      const Weight candidate_weight = item.weight + arc.weight;
+      if (!state.IsReached(arc.to) || candidate_weight < state.weights[arc.to]) {
+        state.Reach(arc.to, candidate_weight, arc.edge_id);
+        state.Push(candidate_weight, arc.to);
+      }
+    }
+  };
+
+  while (!forward.queue.empty() || !backward.queue.empty()) {
+    const bool is_forward_turn = backward.queue.empty()
+        || (!forward.queue.empty() && !(backward.queue.front().weight < forward.queue.front().weight));
+    if (is_forward_turn) {
+      step(forward, backward, up_offsets_, up_arcs_);
+    } else {
+      step(backward, forward, down_offsets_, down_arcs_);
+    }
+  }
+
+  if (!best_weight) {
+    return std::nullopt;
+  }
+
+  // Прямой поиск хранит рёбра, ведущие в вершину, обратный — рёбра, выходящие из неё
+  std::vector<EdgeId> forward_edges;
+  for (VertexId vertex = meeting_vertex; forward.prev_edges[vertex] != NO_EDGE;) {
+    const EdgeId edge_id = forward.prev_edges[vertex];
+    forward_edges.push_back(edge_id);
+    vertex = GetEdgeSource(edge_id);
+  }
+  std::vector<EdgeId> edges;
+  for (auto it = forward_edges.rbegin(); it != forward_edges.rend(); ++it) {
+    UnpackEdge(*it, edges);
+  }
+  for (VertexId vertex = meeting_vertex; backward.prev_edges[vertex] != NO_EDGE;) {
+    const EdgeId edge_id = backward.prev_edges[vertex];
+    UnpackEdge(edge_id, edges);
+    vertex = GetEdgeTarget(edge_id);
+  }
+
+  return RouteInfo{*best_weight, std::move(edges), stats};
+}
+
+template<typename Weight>
+void ContractionHierarchyRouter<Weight>::Save(serialization::Writer &writer) const {
+  writer.WriteArray(ranks_.data(), ranks_.size());
+  writer.WriteArray(shortcuts_.data(), shortcuts_.size());
+}
+
+}  // namespace graph
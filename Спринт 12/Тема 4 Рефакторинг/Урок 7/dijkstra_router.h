@@ -0,0 +1,253 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Направление поиска. У каждого направления в каждом потоке свои рабочие массивы
+enum class SearchDirection {
+  Forward,
+  Backward,
+};
+
+/*
+ * Рабочие массивы поиска кратчайших путей. Вместо очистки массивов перед каждым поиском вершины помечаются
+ * номером текущего поиска: вершина считается достигнутой, только если её метка совпадает с current_mark.
+ * Экземпляры живут в thread_local-хранилище и переиспользуются между запросами, поэтому поиск не выделяет память
+ */
+template<typename Weight>
+struct SearchState {
+  struct QueueItem {
+    Weight weight;
+    VertexId vertex;
+
+    bool operator>(const QueueItem &other) const {
+      return weight > other.weight;
+    }
+  };
+
+  static constexpr EdgeId NO_EDGE = static_cast<EdgeId>(-1);
+
+  std::vector<Weight> weights;
+  std::vector<EdgeId> prev_edges;
+  std::vector<uint32_t> marks;
+  std::vector<QueueItem> queue;
+  uint32_t current_mark = 0;
+
+  static SearchState &ForCurrentThread(SearchDirection direction = SearchDirection::Forward) {
+    thread_local SearchState states[2];
+    return states[static_cast<size_t>(direction)];
+  }
+
+  void Prepare(size_t vertex_count) {
+    if (marks.size() < vertex_count) {
+      weights.resize(vertex_count);
+      prev_edges.resize(vertex_count);
+      marks.resize(vertex_count, 0);
+    }
+    queue.clear();
+    if (++current_mark == 0) {
+      // Счётчик переполнился, старые метки больше нельзя отличить от новых
+      std::fill(marks.begin(), marks.end(), 0);
+      current_mark = 1;
+    }
+  }
+
+  bool IsReached(VertexId vertex) const {
+    return marks[vertex] == current_mark;
+  }
+
+  void Reach(VertexId vertex, Weight weight, EdgeId prev_edge) {
+    marks[vertex] = current_mark;
+    weights[vertex] = weight;
+    prev_edges[vertex] = prev_edge;
+  }
+
+  void Push(Weight weight, VertexId vertex) {
+    queue.push_back({weight, vertex});
+    std::push_heap(queue.begin(), queue.end(), std::greater<>{});
+  }
+
+  QueueItem Pop() {
+    std::pop_heap(queue.begin(), queue.end(), std::greater<>{});
+    const QueueItem item = queue.back();
+    queue.pop_back();
+    return item;
+  }
+
+  // Запись в очереди устарела, если до вершины уже нашёлся более короткий путь
+  bool IsStale(const QueueItem &item) const {
+    return weights[item.vertex] < item.weight;
+  }
+};
+
+/*
+ * Маршрутизатор, который ничего не предпосчитывает и на каждый запрос запускает алгоритм Дейкстры
+ * с двоичной кучей. Память O(V + E), время запроса O((V + E) log V).
+ * Рабочие массивы поиска переиспользуются между запросами, поэтому поиск не выделяет память
+ * (кроме вектора рёбер в ответе). Предпосчёта нет, поэтому изменения графа учитываются сразу
+ */
+template<typename Weight>
+class DijkstraRouter : public RouterBase<Weight> {
+ private:
+  using Graph = DirectedWeightedGraph<Weight>;
+
+ public:
+  using typename RouterBase<Weight>::RouteInfo;
+
+  explicit DijkstraRouter(const Graph &graph);
+
+  std::optional <RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+  // Один поиск из from, который останавливается, когда просмотрены все вершины targets
+  std::vector <std::optional<RouteInfo>> BuildRoutes(VertexId from,
+                                                     const std::vector <VertexId> &targets) const override;
+
+  bool OnEdgeWeightChanged(EdgeId edge_id, Weight old_weight) override;
+  bool OnEdgesAdded(EdgeId first_new_edge) override;
+
+ private:
+  void CheckEdgeWeights(EdgeId first_edge, EdgeId last_edge) const;
+
+  // Запускает поиск из from и останавливает его, как только is_last_target вернёт true для извлечённой вершины
+  template<typename Predicate>
+  SearchState<Weight> &Search(VertexId from, Predicate is_last_target, SearchStats &stats) const;
+
+  std::optional <RouteInfo> ExtractRoute(const SearchState<Weight> &state, VertexId to,
+                                         const SearchStats &stats) const;
+
+  static constexpr Weight ZERO_WEIGHT{};
+  static constexpr EdgeId NO_EDGE = SearchState<Weight>::NO_EDGE;
+  const Graph &graph_;
+};
+
+template<typename Weight>
+DijkstraRouter<Weight>::DijkstraRouter(const Graph &graph)
+    : graph_(graph) {
+  CheckEdgeWeights(0, graph.GetEdgeCount());
+}
+
+template<typename Weight>
+void DijkstraRouter<Weight>::CheckEdgeWeights(EdgeId first_edge, EdgeId last_edge) const {
+  for (EdgeId edge_id = first_edge; edge_id < last_edge; ++edge_id) {
+    if (graph_.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+      throw std::domain_error("Edges' weights should be non-negative");
+    }
+  }
+}
+
+template<typename Weight>
+bool DijkstraRouter<Weight>::OnEdgeWeightChanged(EdgeId edge_id, Weight) {
+  CheckEdgeWeights(edge_id, edge_id + 1);
+  return true;
+}
+
+template<typename Weight>
+bool DijkstraRouter<Weight>::OnEdgesAdded(EdgeId first_new_edge) {
+  CheckEdgeWeights(first_new_edge, graph_.GetEdgeCount());
+  return true;
+}
+
+template<typename Weight>
+template<typename Predicate>
+SearchState<Weight> &DijkstraRouter<Weight>::Search(VertexId from, Predicate is_last_target,
+                                                    SearchStats &stats) const {
+  auto &state = SearchState<Weight>::ForCurrentThread();
+  state.Prepare(graph_.GetVertexCount());
+  state.Reach(from, ZERO_WEIGHT, NO_EDGE);
+  state.Push(ZERO_WEIGHT, from);
+
+  while (!state.queue.empty()) {
+    const auto item = state.Pop();
+    if (state.IsStale(item)) {
+      continue;
+    }
+    ++stats.settled_vertices;
+    if (is_last_target(item.vertex)) {
+      break;
+    }
+    graph_.ForEachIncidentEdge(item.vertex, [&state, &item, &stats](EdgeId edge_id, VertexId edge_to,
+                                                                    Weight edge_weight) {
+      ++stats.relaxed_edges;
+      const Weight candidate_weight = item.weight + edge_weight;
+      if (!state.IsReached(edge_to) || candidate_weight < state.weights[edge_to]) {
+        state.Reach(edge_to, candidate_weight, edge_id);
+        state.Push(candidate_weight, edge_to);
+      }
+    });
+  }
+  return state;
+}
+
+template<typename Weight>
+std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::ExtractRoute(
+    const SearchState<Weight> &state, VertexId to, const SearchStats &stats) const {
+  if (!state.IsReached(to)) {
+    return std::nullopt;
+  }
+  std::vector<EdgeId> edges;
+  for (EdgeId edge_id = state.prev_edges[to]; edge_id != NO_EDGE;
+       edge_id = state.prev_edges[graph_.GetEdge(edge_id).from]) {
+    edges.push_back(edge_id);
+  }
+  std::reverse(edges.begin(), edges.end());
+
+  return RouteInfo{state.weights[to], std::move(edges), stats};
+}
+
+template<typename Weight>
+std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::BuildRoute(VertexId from,
+                                                                                             VertexId to) const {
+  const size_t vertex_count = graph_.GetVertexCount();
+  if (from >= vertex_count || to >= vertex_count) {
+    throw std::out_of_range("Vertex id is out of range");
+  }
+
+  SearchStats stats;
+  const auto &state = Search(from, [to](VertexId vertex) { return vertex == to; }, stats);
+  return ExtractRoute(state, to, stats);
+}
+
+template<typename Weight>
+std::vector<std::optional<typename DijkstraRouter<Weight>::RouteInfo>> DijkstraRouter<Weight>::BuildRoutes(
+    VertexId from, const std::vector<VertexId> &targets) const {
+  const size_t vertex_count = graph_.GetVertexCount();
+  if (from >= vertex_count) {
+    throw std::out_of_range("Vertex id is out of range");
+  }
+  if (targets.empty()) {
+    return {};
+  }
+  std::vector<VertexId> pending_targets(targets);
+  std::sort(pending_targets.begin(), pending_targets.end());
+  pending_targets.erase(std::unique(pending_targets.begin(), pending_targets.end()), pending_targets.end());
+  if (!pending_targets.empty() && pending_targets.back() >= vertex_count) {
+    throw std::out_of_range("Vertex id is out of range");
+  }
+
+  // Каждая вершина извлекается из очереди не более одного раза, поэтому достаточно считать извлечённые цели.
+  // Все маршруты пачки получают счётчики общего поиска
+  size_t pending_count = pending_targets.size();
+  SearchStats stats;
+  const auto &state = Search(from, [&pending_targets, &pending_count](VertexId vertex) {
+    return std::binary_search(pending_targets.begin(), pending_targets.end(), vertex) && --pending_count == 0;
+  }, stats);
+
+  std::vector<std::optional<RouteInfo>> routes;
+  routes.reserve(targets.size());
+  for (const VertexId to : targets) {
+    routes.push_back(ExtractRoute(state, to, stats));
+  }
+  return routes;
+}
+
+}  // namespace graph
@@ -0,0 +1,57 @@
+#include "distance_table.h"
+
+#include <stdexcept>
+#include <string>
+
+using namespace tc;
+
+void DistanceTable::Set(StopId from, StopId to, size_t distance) {
+  if (distance > std::numeric_limits<uint32_t>::max()) {
+    throw std::out_of_range("Distance is too large: " + std::to_string(distance));
+  }
+  Entry &entry = FindOrInsert(Pack(from, to));
+  entry.distance = static_cast<uint32_t>(distance);
+  entry.is_explicit = 1;
+  // Для from == to это та же запись, она уже явная
+  if (Entry &reverse_entry = FindOrInsert(Pack(to, from)); !reverse_entry.is_explicit) {
+    reverse_entry.distance = static_cast<uint32_t>(distance);
+  }
+}
+
+DistanceTable::Entry &DistanceTable::FindOrInsert(uint64_t key) {
+  if ((size_ + 1) * 2 > entries_.size()) {
+    Rehash(entries_.empty() ? 16 : entries_.size() * 2);
+  }
+  const size_t mask = entries_.size() - 1;
+  for (size_t slot = GetSlot(key);; slot = (slot + 1) & mask) {
+    Entry &entry = entries_[slot];
+    if (entry.key == key) {
+      return entry;
+    }
+    if (entry.key == EMPTY_KEY) {
+      entry.key = key;
+      ++size_;
+      return entry;
+    }
+  }
+}
+
+void DistanceTable::Rehash(size_t capacity) {
+  std::vector<Entry> entries(capacity);
+  entries_.swap(entries);
+  shift_ = 64;
+  for (size_t size = capacity; size > 1; size /= 2) {
+    --shift_;
+  }
+  const size_t mask = capacity - 1;
+  for (const Entry &entry : entries) {
+    if (entry.key == EMPTY_KEY) {
+      continue;
+    }
+    size_t slot = GetSlot(entry.key);
+    while (entries_[slot].key != EMPTY_KEY) {
+      slot = (slot + 1) & mask;
+    }
+    entries_[slot] = entry;
+  }
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "domain.h"
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace tc {
+
+/*
+ * Расстояния по дорогам между парами остановок: хэш-таблица с открытой адресацией и линейным пробированием,
+ * ключ — упакованная в 64 бита пара номеров остановок. Вместе с явно заданным расстоянием А -> Б таблица
+ * хранит его же для Б -> А, пока то не задано явно, поэтому поиск расстояния — один проход по таблице
+ * без повторного поиска в обратную сторону
+ */
+class DistanceTable {
+ public:
+  static constexpr size_t NO_DISTANCE = std::numeric_limits<size_t>::max();
+
+  // Задаёт расстояние from -> to и, если обратное не задано явно, to -> from. Повторный вызов заменяет расстояние
+  void Set(StopId from, StopId to, size_t distance);
+
+  // Расстояние from -> to, а если оно не задано — to -> from. NO_DISTANCE, если не задано ни одно из них
+  size_t Get(StopId from, StopId to) const {
+    const Entry *entry = Find(Pack(from, to));
+    return entry == nullptr ? NO_DISTANCE : entry->distance;
+  }
+
+  // Вызывает visitor(from, to, distance) для каждого явно заданного расстояния
+  template<typename Visitor>
+  void ForEachExplicit(Visitor &&visitor) const {
+    for (const Entry &entry : entries_) {
+      if (entry.key != EMPTY_KEY && entry.is_explicit) {
+        visitor(static_cast<StopId>(entry.key >> 32), static_cast<StopId>(entry.key), size_t{entry.distance});
+      }
+    }
+  }
+
+ private:
+  struct Entry {
+    uint64_t key = EMPTY_KEY;
+    uint32_t distance = 0;
+    uint32_t is_explicit = 0;  // Расстояние задано для этого направления, а не взято из обратного
+  };
+
+  static constexpr uint64_t EMPTY_KEY = std::numeric_limits<uint64_t>::max();
+
+  static uint64_t Pack(StopId from, StopId to) {
+    return static_cast<uint64_t>(from) << 32 | to;
+  }
+
+  // Мультипликативное хэширование: старшие биты произведения на нечётную константу зависят от всех битов ключа
+  size_t GetSlot(uint64_t key) const {
+    return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> shift_);
+  }
+
+  const Entry *Find(uint64_t key) const {
+    if (entries_.empty()) {
+      return nullptr;
+    }
+    const size_t mask = entries_.size() - 1;
+    for (size_t slot = GetSlot(key);; slot = (slot + 1) & mask) {
+      const Entry &entry = entries_[slot];
+      if (entry.key == key) {
+        return &entry;
+      }
+      if (entry.key == EMPTY_KEY) {
+        return nullptr;
+      }
+    }
+  }
+
+  // Находит запись по ключу или добавляет пустую, ссылка действительна до следующего добавления
+  Entry &FindOrInsert(uint64_t key);
+  void Rehash(size_t capacity);
+
+  std::vector<Entry> entries_;  // Размер — степень двойки, заполнено не больше половины
+  size_t size_ = 0;
+  unsigned shift_ = 64;  // 64 - log2(entries_.size())
+};
+
+}  // namespace tc
@@ -1,25 +1,53 @@
 #pragma once
 
 #include "geo.h"
+#include "ranges.h"
 
 #include <cstddef>
+#include <cstdint>
+#include <memory_resource>
 #include <utility>
 #include <vector>
-#include <string>
+#include <string_view>
 
 namespace tc {
 
+// Плотные номера остановок и маршрутов в порядке добавления в справочник: ими индексируются массивы,
+// чтобы не искать по названию внутри справочника и маршрутизатора
+using StopId = uint32_t;
+using RouteId = uint32_t;
+
+// Названия остановок и маршрутов и их списки смежности лежат в памяти справочника, которая освобождается
+// целиком вместе с ним, поэтому объекты действительны, пока жив справочник
 struct Route;
 struct Stop {
-  std::string name_;
+  std::string_view name_;
   geo::Coordinates coordinates_;
-  std::vector<const Route *> routes_;
+  // Маршруты через остановку без повторов, в порядке добавления. Список строит TransportCatalogue::Finalize
+  ranges::Range<const Route *const *> routes_{nullptr, nullptr};
+  StopId id_{};
+};
+
+// Расписание маршрута: автобусы отправляются с начальной остановки каждые headway_ минут
+// с first_departure_ по last_departure_ (в минутах от начала суток). Нулевой интервал — расписание не задано
+struct RouteSchedule {
+  double headway_ = 0;
+  double first_departure_ = 0;
+  double last_departure_ = 24 * 60;
 };
 
 struct Route {
-  std::string name_;
-  std::vector<const Stop *> stops_;
+  std::string_view name_;
+  std::pmr::vector<const Stop *> stops_;
   bool is_rounded;
+  RouteSchedule schedule_{};
+  RouteId id_{};
+};
+
+// Остановка рядом с заданной точкой и расстояние до неё по прямой в метрах
+struct NearbyStop {
+  const Stop *stop_;
+  double distance_;
 };
 
 struct RouteInfo {
@@ -29,14 +57,4 @@ struct RouteInfo {
   size_t real_length_{};
 };
 
-struct StopsPairHasher {
-  size_t operator()(const std::pair<const Stop *, const Stop *>& stops) const;
-
-  // Расстояния между пунктами А и Б могут отличаться в зависимости от направления движения. Хэш пары остановок
-  // вычисляется путём сложения хэшей двух остановок и является одинаковым для пар вида (А; Б) и (Б; А). Таким образом
-  // необходимо умножать одно из слагаемых на произвольный коэффициент для предотвращения коллизий.
-  static constexpr int salt_ = 10;
-  std::hash<std::string> hasher_;
-};
-
 }  // namespace tc
@@ -1,9 +1,24 @@
 #include "geo.h"
 
+#include <algorithm>
 #include <cmath>
 
 namespace geo {
 
+namespace {
+
+// Точка на сфере радиуса radius: общая тригонометрия ToPoint3D и SpherePoints::Add.
+// Умножение на единичный радиус точное, поэтому единичная сфера получается без лишнего округления
+Point3D ToSpherePoint(Coordinates coordinates, double radius) {
+  using namespace std;
+  const double cos_lat = cos(coordinates.lat * DEGREES_TO_RADIANS);
+  return {radius * cos_lat * cos(coordinates.lng * DEGREES_TO_RADIANS),
+          radius * cos_lat * sin(coordinates.lng * DEGREES_TO_RADIANS),
+          radius * sin(coordinates.lat * DEGREES_TO_RADIANS)};
+}
+
+}  // namespace
+
 bool Coordinates::operator==(const Coordinates& other) const {
   return lat == other.lat && lng == other.lng;
 }
@@ -17,11 +32,72 @@ double ComputeDistance(Coordinates from, Coordinates to) {
   if (from == to) {
     return 0;
   }
-  static const double rad = M_PI / 180.;
-  static const double earth_radius = 6371000;
-  return acos(sin(from.lat * rad) * sin(to.lat * rad)
-                  + cos(from.lat * rad) * cos(to.lat * rad)
-                      * cos(abs(from.lng - to.lng) * rad)) * earth_radius;
+  return acos(sin(from.lat * DEGREES_TO_RADIANS) * sin(to.lat * DEGREES_TO_RADIANS)
+                  + cos(from.lat * DEGREES_TO_RADIANS) * cos(to.lat * DEGREES_TO_RADIANS)
+                      * cos(abs(from.lng - to.lng) * DEGREES_TO_RADIANS)) * EARTH_RADIUS;
+}
+
+Point3D ToPoint3D(Coordinates coordinates) {
+  return ToSpherePoint(coordinates, EARTH_RADIUS);
+}
+
+double ComputeChordDistance(const Point3D &from, const Point3D &to) {
+  const double dx = from.x - to.x;
+  const double dy = from.y - to.y;
+  const double dz = from.z - to.z;
+  return std::sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+void SpherePoints::Add(Coordinates coordinates) {
+  const Point3D unit = ToSpherePoint(coordinates, 1.);
+  x_.push_back(unit.x);
+  y_.push_back(unit.y);
+  z_.push_back(unit.z);
+}
+
+void SpherePoints::AddFrom(const SpherePoints &points, size_t index) {
+  x_.push_back(points.x_[index]);
+  y_.push_back(points.y_[index]);
+  z_.push_back(points.z_[index]);
+}
+
+void SpherePoints::Reserve(size_t size) {
+  x_.reserve(size);
+  y_.reserve(size);
+  z_.reserve(size);
+}
+
+size_t SpherePoints::GetSize() const {
+  return x_.size();
+}
+
+std::vector<double> SpherePoints::ComputeSegmentDistances() const {
+  const size_t count = x_.size() < 2 ? 0 : x_.size() - 1;
+  std::vector<double> distances(count);
+  const double *x = x_.data();
+  const double *y = y_.data();
+  const double *z = z_.data();
+  double *cosines = distances.data();
+  // Косинусы углов между соседними точками. У совпадающих точек косинус ровно 1, как и расстояние 0
+  // в ComputeDistance, а из-за округления он не должен выйти за 1
+  for (size_t i = 0; i < count; ++i) {
+    const double dot = x[i] * x[i + 1] + y[i] * y[i + 1] + z[i] * z[i + 1];
+    const bool is_same = x[i] == x[i + 1] && y[i] == y[i + 1] && z[i] == z[i + 1];
+    cosines[i] = is_same ? 1. : std::min(dot, 1.);
+  }
+  for (size_t i = 0; i < count; ++i) {
+    distances[i] = std::acos(cosines[i]) * EARTH_RADIUS;
+  }
+  return distances;
+}
+
+std::vector<double> ComputeSegmentDistances(const Coordinates *coordinates, size_t count) {
+  SpherePoints points;
+  points.Reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    points.Add(coordinates[i]);
+  }
+  return points.ComputeSegmentDistances();
 }
 
 }  // namespace geo
\ No newline at end of file
@@ -1,9 +1,16 @@
 #pragma once
 
 #include <cmath>
+#include <cstddef>
+#include <vector>
 
 namespace geo {
 
+// Радиус Земли в метрах, общий для всех расчётов расстояний
+inline constexpr double EARTH_RADIUS = 6371000;
+// Множитель перевода градусов в радианы
+inline constexpr double DEGREES_TO_RADIANS = M_PI / 180.;
+
 struct Coordinates {
   double lat;
   double lng;
@@ -13,4 +20,47 @@ struct Coordinates {
 
 double ComputeDistance(Coordinates from, Coordinates to);
 
+// Точка на сфере радиуса Земли в декартовых координатах, в метрах
+struct Point3D {
+  double x;
+  double y;
+  double z;
+};
+
+Point3D ToPoint3D(Coordinates coordinates);
+
+// Длина хорды между точками. Она не больше расстояния по поверхности и, в отличие от ComputeDistance,
+// точно выполняет неравенство треугольника, поэтому годится для оценок снизу. Вычисляется без тригонометрии
+double ComputeChordDistance(const Point3D &from, const Point3D &to);
+
+/*
+ * Точки на единичной сфере в раскладке «структура массивов»: координаты x, y, z хранятся в отдельных массивах.
+ * Синусы и косинусы широты и долготы считаются один раз при добавлении точки, а косинус угла между точками —
+ * скалярное произведение, поэтому пакетный расчёт расстояний идёт одним циклом без тригонометрии и ветвлений.
+ * При -O2 GCC оставляет этот цикл скалярным, векторизует его только -O3 или -ftree-vectorize.
+ * Остаётся арккосинус на каждое расстояние.
+ * Результат отличается от ComputeDistance только округлением косинуса угла, которое арккосинус усиливает
+ * на коротких расстояниях (у ComputeDistance та же погрешность): отличие не больше 0.2 м, а на пролётах
+ * от 100 м — не больше 2e-6 от длины. Совпадающие точки, как и в ComputeDistance, дают ровно 0
+ */
+class SpherePoints {
+ public:
+  void Add(Coordinates coordinates);
+  // Копирует уже посчитанную точку index из другого набора, без тригонометрии
+  void AddFrom(const SpherePoints &points, size_t index);
+  void Reserve(size_t size);
+  size_t GetSize() const;
+
+  // Расстояния по поверхности Земли между соседними точками: i-е — между точками i и i + 1
+  std::vector<double> ComputeSegmentDistances() const;
+
+ private:
+  std::vector<double> x_;
+  std::vector<double> y_;
+  std::vector<double> z_;
+};
+
+// Расстояния между соседними точками массива из count точек, count - 1 штук
+std::vector<double> ComputeSegmentDistances(const Coordinates *coordinates, size_t count);
+
 }  // namespace geo
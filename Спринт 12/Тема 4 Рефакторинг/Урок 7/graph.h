@@ -3,6 +3,7 @@
 #include "ranges.h"
 
 #include <cstdlib>
+#include <stdexcept>
 #include <vector>
 
 namespace graph {
@@ -26,16 +27,51 @@ class DirectedWeightedGraph {
  public:
   DirectedWeightedGraph() = default;
   explicit DirectedWeightedGraph(size_t vertex_count);
+  VertexId AddVertex();
   EdgeId AddEdge(const Edge<Weight> &edge);
 
+  // Меняет вес ребра, в том числе в замороженном графе. Занимает время, пропорциональное числу рёбер,
+  // исходящих из начала ребра
+  void SetEdgeWeight(EdgeId edge_id, Weight weight);
+
+  /**
+   * Упаковывает списки смежности в CSR-представление: массив смещений и сплошные массивы исходящих рёбер.
+   * После заморозки добавлять рёбра нельзя, зато обход соседей не прыгает по отдельным векторам
+   */
+  void Freeze();
+  bool IsFrozen() const;
+
+  // Возвращает графу списки смежности, чтобы в него снова можно было добавлять вершины и рёбра
+  void Unfreeze();
+
   size_t GetVertexCount() const;
   size_t GetEdgeCount() const;
   const Edge<Weight> &GetEdge(EdgeId edge_id) const;
   IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
 
+  /**
+   * Вызывает visitor(edge_id, to, weight) для каждого исходящего из вершины ребра.
+   * Предназначен для горячих циклов поиска: на замороженном графе не проверяет границы
+   * и не обращается к массиву рёбер
+   */
+  template<typename Visitor>
+  void ForEachIncidentEdge(VertexId vertex, Visitor &&visitor) const;
+
  private:
+  struct Arc {
+    VertexId to;
+    Weight weight;
+  };
+
   std::vector <Edge<Weight>> edges_;
   std::vector <IncidenceList> incidence_lists_;
+
+  // CSR-представление замороженного графа. Исходящие рёбра вершины v занимают
+  // позиции [offsets_[v], offsets_[v + 1]) в массивах incident_edge_ids_ и arcs_
+  bool is_frozen_ = false;
+  std::vector<size_t> offsets_;
+  IncidenceList incident_edge_ids_;
+  std::vector<Arc> arcs_;
 };
 
 template<typename Weight>
@@ -43,17 +79,86 @@ DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count)
     : incidence_lists_(vertex_count) {
 }
 
+template<typename Weight>
+VertexId DirectedWeightedGraph<Weight>::AddVertex() {
+  if (is_frozen_) {
+    throw std::logic_error("Can't add a vertex to a frozen graph");
+  }
+  incidence_lists_.emplace_back();
+  return incidence_lists_.size() - 1;
+}
+
 template<typename Weight>
 EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight> &edge) {
+  if (is_frozen_) {
+    throw std::logic_error("Can't add an edge to a frozen graph");
+  }
   edges_.push_back(edge);
   const EdgeId id = edges_.size() - 1;
   incidence_lists_.at(edge.from).push_back(id);
   return id;
 }
 
+template<typename Weight>
+void DirectedWeightedGraph<Weight>::SetEdgeWeight(EdgeId edge_id, Weight weight) {
+  auto &edge = edges_.at(edge_id);
+  edge.weight = weight;
+  if (is_frozen_) {
+    for (size_t i = offsets_[edge.from], end = offsets_[edge.from + 1]; i < end; ++i) {
+      if (incident_edge_ids_[i] == edge_id) {
+        arcs_[i].weight = weight;
+        break;
+      }
+    }
+  }
+}
+
+template<typename Weight>
+void DirectedWeightedGraph<Weight>::Freeze() {
+  if (is_frozen_) {
+    return;
+  }
+  const size_t vertex_count = incidence_lists_.size();
+  offsets_.assign(vertex_count + 1, 0);
+  incident_edge_ids_.reserve(edges_.size());
+  arcs_.reserve(edges_.size());
+  for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+    for (const EdgeId edge_id : incidence_lists_[vertex]) {
+      incident_edge_ids_.push_back(edge_id);
+      arcs_.push_back({edges_[edge_id].to, edges_[edge_id].weight});
+    }
+    offsets_[vertex + 1] = incident_edge_ids_.size();
+  }
+  // Списки смежности больше не нужны, освобождаем их память целиком
+  std::vector<IncidenceList>().swap(incidence_lists_);
+  is_frozen_ = true;
+}
+
+template<typename Weight>
+bool DirectedWeightedGraph<Weight>::IsFrozen() const {
+  return is_frozen_;
+}
+
+template<typename Weight>
+void DirectedWeightedGraph<Weight>::Unfreeze() {
+  if (!is_frozen_) {
+    return;
+  }
+  const size_t vertex_count = offsets_.size() - 1;
+  incidence_lists_.resize(vertex_count);
+  for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+    incidence_lists_[vertex].assign(incident_edge_ids_.begin() + offsets_[vertex],
+                                    incident_edge_ids_.begin() + offsets_[vertex + 1]);
+  }
+  std::vector<size_t>().swap(offsets_);
+  IncidenceList().swap(incident_edge_ids_);
+  std::vector<Arc>().swap(arcs_);
+  is_frozen_ = false;
+}
+
 template<typename Weight>
 size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
-  return incidence_lists_.size();
+  return is_frozen_ ? offsets_.size() - 1 : incidence_lists_.size();
 }
 
 template<typename Weight>
@@ -69,7 +174,26 @@ const Edge<Weight> &DirectedWeightedGraph<Weight>::GetEdge(EdgeId edge_id) const
 template<typename Weight>
 typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
 DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
+  if (is_frozen_) {
+    const auto begin = incident_edge_ids_.begin();
+    return {begin + offsets_.at(vertex), begin + offsets_.at(vertex + 1)};
+  }
   return ranges::AsRange(incidence_lists_.at(vertex));
 }
 
+template<typename Weight>
+template<typename Visitor>
+void DirectedWeightedGraph<Weight>::ForEachIncidentEdge(VertexId vertex, Visitor &&visitor) const {
+  if (is_frozen_) {
+    for (size_t i = offsets_[vertex], end = offsets_[vertex + 1]; i < end; ++i) {
+      visitor(incident_edge_ids_[i], arcs_[i].to, arcs_[i].weight);
+    }
+    return;
+  }
+  for (const EdgeId edge_id : incidence_lists_[vertex]) {
+    const auto &edge = edges_[edge_id];
+    visitor(edge_id, edge.to, edge.weight);
+  }
+}
+
 }  // namespace graph
@@ -1,45 +1,228 @@
 #include "json.h"
 
-#include <iterator>
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <string_view>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Размер блока чтения из потока. Тест разбора задаёт маленький блок, чтобы лексемы чаще попадали на границу блоков
+#ifndef JSON_INPUT_BLOCK_SIZE
+#define JSON_INPUT_BLOCK_SIZE (1 << 16)
+#endif
 
 namespace json {
 
 namespace {
 using namespace std::literals;
 
-Node LoadNode(std::istream &input);
-Node LoadString(std::istream &input);
+/*
+ * Поиск по тексту блоками по 16 байт на SSE2: сравнения всего блока с нужными символами собираются
+ * в битовую маску, и номер первого совпадения — номер её младшего единичного бита.
+ * Без SSE2 — тот же поиск по одному байту. Оба варианта находят одну и ту же позицию
+ */
+
+// Первый из символов ", \, \n, \r в [begin, end) — то, на чём обычный кусок строки заканчивается, иначе end
+const char *FindStringStop(const char *begin, const char *end) {
+#ifdef __SSE2__
+  const __m128i quotes = _mm_set1_epi8('"');
+  const __m128i backslashes = _mm_set1_epi8('\\');
+  const __m128i line_feeds = _mm_set1_epi8('\n');
+  const __m128i carriage_returns = _mm_set1_epi8('\r');
+  for (; end - begin >= 16; begin += 16) {
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+    const __m128i stops = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(block, quotes), _mm_cmpeq_epi8(block, backslashes)),
+        _mm_or_si128(_mm_cmpeq_epi8(block, line_feeds), _mm_cmpeq_epi8(block, carriage_returns)));
+    if (const int mask = _mm_movemask_epi8(stops); mask != 0) {
+      return begin + __builtin_ctz(static_cast<unsigned>(mask));
+    }
+  }
+#endif
+  while (begin != end && *begin != '"' && *begin != '\\' && *begin != '\n' && *begin != '\r') {
+    ++begin;
+  }
+  return begin;
+}
 
-std::string LoadLiteral(std::istream &input) {
-  std::string s;
-  while (std::isalpha(input.peek())) {
-    s.push_back(static_cast<char>(input.get()));
+// Первый непробельный в смысле std::isspace символ в [begin, end), иначе end
+const char *SkipSpaces(const char *begin, const char *end) {
+  // Между значениями обычно не больше пары пробельных символов: блоки загружаются только для отступов длиннее
+  for (int i = 0; i < 2; ++i, ++begin) {
+    if (begin == end || !std::isspace(static_cast<unsigned char>(*begin))) {
+      return begin;
+    }
   }
-  return s;
+#ifdef __SSE2__
+  // Пробельные символы — пробел и коды с \t по \r, то есть c - '\t' <= 4 без знака
+  const __m128i spaces = _mm_set1_epi8(' ');
+  const __m128i tabs = _mm_set1_epi8('\t');
+  const __m128i max_offsets = _mm_set1_epi8(4);
+  for (; end - begin >= 16; begin += 16) {
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+    const __m128i offsets = _mm_sub_epi8(block, tabs);
+    const __m128i is_space = _mm_or_si128(_mm_cmpeq_epi8(block, spaces),
+                                          _mm_cmpeq_epi8(_mm_min_epu8(offsets, max_offsets), offsets));
+    if (const int mask = _mm_movemask_epi8(is_space); mask != 0xFFFF) {
+      return begin + __builtin_ctz(~static_cast<unsigned>(mask));
+    }
+  }
+#endif
+  while (begin != end && std::isspace(static_cast<unsigned char>(*begin))) {
+    ++begin;
+  }
+  return begin;
 }
 
-Node LoadArray(std::istream &input) {
+// Разбираемый текст: строка в памяти или поток, который читается блоками в буфер. Чтение символа — сдвиг
+// указателя по буферу, без виртуальных вызовов и проверок состояния потока на каждый байт, как у std::istream
+class Input {
+ public:
+  static constexpr int END = std::char_traits<char>::eof();
+
+  explicit Input(std::string_view text)
+      : pos_(text.data()), end_(text.data() + text.size()) {}
+
+  explicit Input(std::istream &stream)
+      : stream_(&stream) {}
+
+  // Очередной символ как unsigned char или END в конце текста, как у std::istream::peek
+  int Peek() {
+    if (pos_ == end_ && !Refill()) {
+      return END;
+    }
+    return static_cast<unsigned char>(*pos_);
+  }
+
+  bool IsEnd() {
+    return Peek() == END;
+  }
+
+  const char *GetPosition() const {
+    return pos_;
+  }
+
+  void Advance() {
+    ++pos_;
+  }
+
+  // Есть ли непрочитанные символы в буфере: в отличие от IsEnd, буфер не подкачивается
+  bool IsBuffered() const {
+    return pos_ != end_;
+  }
+
+  // Возвращает только что прочитанный символ: между чтением и возвратом буфер не подкачивается
+  void PutBack() {
+    --pos_;
+  }
+
+  // Переходит к первому символу, на котором заканчивается обычный кусок строки, или в конец буфера
+  void SkipStringRun() {
+    pos_ = FindStringStop(pos_, end_);
+  }
+
+  // Пропускает пробельные символы и читает следующий, как input >> c. В конце текста c не меняется
+  bool ReadSignificant(char &c) {
+    while ((pos_ = SkipSpaces(pos_, end_)) == end_) {
+      if (!Refill()) {
+        return false;
+      }
+    }
+    c = *pos_++;
+    return true;
+  }
+
+  // Число или литерал разбирается целиком из буфера: при подкачке начатая лексема переносится в его начало
+  void StartToken() {
+    token_begin_ = pos_;
+  }
+
+  std::string_view FinishToken() {
+    const std::string_view token(token_begin_, static_cast<size_t>(pos_ - token_begin_));
+    token_begin_ = nullptr;
+    return token;
+  }
+
+ private:
+  static constexpr size_t BLOCK_SIZE = JSON_INPUT_BLOCK_SIZE;
+
+  bool Refill();
+
+  std::istream *stream_ = nullptr;  // nullptr, если весь текст уже в памяти
+  std::string buffer_;
+  const char *pos_ = nullptr;
+  const char *end_ = nullptr;
+  const char *token_begin_ = nullptr;
+};
+
+bool Input::Refill() {
+  if (stream_ == nullptr || !*stream_) {
+    return false;
+  }
+  const size_t kept = token_begin_ == nullptr ? 0 : static_cast<size_t>(end_ - token_begin_);
+  if (kept != 0) {
+    std::memmove(buffer_.data(), token_begin_, kept);
+  }
+  // Буфер растёт, только если одна лексема длиннее блока
+  buffer_.resize(std::max(buffer_.size(), kept + BLOCK_SIZE));
+  stream_->read(buffer_.data() + kept, static_cast<std::streamsize>(buffer_.size() - kept));
+  const auto read = static_cast<size_t>(stream_->gcount());
+  if (token_begin_ != nullptr) {
+    token_begin_ = buffer_.data();
+  }
+  pos_ = buffer_.data() + kept;
+  end_ = pos_ + read;
+  return read != 0;
+}
+
+Node LoadNode(Input &input);
+std::string LoadString(Input &input);
+
+std::string_view LoadLiteral(Input &input) {
+  input.StartToken();
+  while (std::isalpha(input.Peek())) {
+    input.Advance();
+  }
+  return input.FinishToken();
+}
+
+Node LoadArray(Input &input) {
   std::vector<Node> result;
 
-  for (char c; input >> c && c != ']';) {
+  for (char c;;) {
+    if (!input.ReadSignificant(c)) {
+      throw ParsingError("Array parsing error"s);
+    }
+    if (c == ']') {
+      break;
+    }
     if (c != ',') {
-      input.putback(c);
+      input.PutBack();
     }
     result.push_back(LoadNode(input));
   }
-  if (!input) {
-    throw ParsingError("Array parsing error"s);
-  }
   return Node(std::move(result));
 }
 
-Node LoadDict(std::istream &input) {
+Node LoadDict(Input &input) {
   Dict dict;
 
-  for (char c; input >> c && c != '}';) {
+  for (char c;;) {
+    if (!input.ReadSignificant(c)) {
+      throw ParsingError("Dictionary parsing error"s);
+    }
+    if (c == '}') {
+      break;
+    }
     if (c == '"') {
-      std::string key = LoadString(input).AsString();
-      if (input >> c && c == ':') {
+      std::string key = LoadString(input);
+      if (input.ReadSignificant(c) && c == ':') {
         if (dict.find(key) != dict.end()) {
           throw ParsingError("Duplicate key '"s + key + "' have been found");
         }
@@ -51,30 +234,30 @@ Node LoadDict(std::istream &input) {
       throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
     }
   }
-  if (!input) {
-    throw ParsingError("Dictionary parsing error"s);
-  }
   return Node(std::move(dict));
 }
 
-Node LoadString(std::istream &input) {
-  auto it = std::istreambuf_iterator<char>(input);
-  auto end = std::istreambuf_iterator<char>();
-  std::string s;
+// Дописывает к s остаток строки до закрывающей кавычки, заменяя escape-последовательности символами
+void AppendString(Input &input, std::string &s) {
   while (true) {
-    if (it == end) {
+    // Обычные символы до кавычки, escape-последовательности или конца строки копируются одним куском
+    const char *run_begin = input.GetPosition();
+    input.SkipStringRun();
+    s.append(run_begin, input.GetPosition());
+
+    if (input.IsEnd()) {
       throw ParsingError("String parsing error");
     }
-    const char ch = *it;
+    const char ch = static_cast<char>(input.Peek());
     if (ch == '"') {
-      ++it;
+      input.Advance();
       break;
     } else if (ch == '\\') {
-      ++it;
-      if (it == end) {
+      input.Advance();
+      if (input.IsEnd()) {
         throw ParsingError("String parsing error");
       }
-      const char escaped_char = *(it);
+      const char escaped_char = static_cast<char>(input.Peek());
       switch (escaped_char) {
         case 'n':s.push_back('\n');
           break;
@@ -88,63 +271,75 @@ Node LoadString(std::istream &input) {
           break;
         default:throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
       }
+      input.Advance();
     } else if (ch == '\n' || ch == '\r') {
       throw ParsingError("Unexpected end of line"s);
-    } else {
-      s.push_back(ch);
     }
-    ++it;
+    // Иначе кусок строки дошёл до конца буфера и продолжается в подкачанном блоке
   }
+}
+
+std::string LoadString(Input &input) {
+  std::string s;
+  AppendString(input, s);
+  return s;
+}
 
-  return Node(std::move(s));
+/*
+ * Строка без escape-последовательностей, целиком лежащая в буфере, возвращается как представление буфера,
+ * остальные собираются в buffer. Представление действительно до следующего чтения из input
+ */
+std::string_view LoadStringView(Input &input, std::string &buffer) {
+  const char *begin = input.GetPosition();
+  input.SkipStringRun();
+  if (input.IsBuffered() && input.Peek() == '"') {
+    const std::string_view s(begin, static_cast<size_t>(input.GetPosition() - begin));
+    input.Advance();
+    return s;
+  }
+  buffer.assign(begin, input.GetPosition());
+  AppendString(input, buffer);
+  return buffer;
 }
 
-Node LoadBool(std::istream &input) {
+Node LoadBool(Input &input) {
   const auto s = LoadLiteral(input);
   if (s == "true"sv) {
     return Node{true};
   } else if (s == "false"sv) {
     return Node{false};
   } else {
-    throw ParsingError("Failed to parse '"s + s + "' as bool"s);
+    throw ParsingError("Failed to parse '"s + std::string(s) + "' as bool"s);
   }
 }
 
-Node LoadNull(std::istream &input) {
+Node LoadNull(Input &input) {
   if (auto literal = LoadLiteral(input); literal == "null"sv) {
     return Node{nullptr};
   } else {
-    throw ParsingError("Failed to parse '"s + literal + "' as null"s);
+    throw ParsingError("Failed to parse '"s + std::string(literal) + "' as null"s);
   }
 }
 
-Node LoadNumber(std::istream &input) {
-  std::string parsed_num;
+Node LoadNumber(Input &input) {
+  input.StartToken();
 
-  // Считывает в parsed_num очередной символ из input
-  auto read_char = [&parsed_num, &input] {
-    parsed_num += static_cast<char>(input.get());
-    if (!input) {
-      throw ParsingError("Failed to read number from stream"s);
-    }
-  };
-
-  // Считывает одну или более цифр в parsed_num из input
-  auto read_digits = [&input, read_char] {
-    if (!std::isdigit(input.peek())) {
+  // Пропускает одну или более цифр
+  auto read_digits = [&input] {
+    if (!std::isdigit(input.Peek())) {
       throw ParsingError("A digit is expected"s);
     }
-    while (std::isdigit(input.peek())) {
-      read_char();
+    while (std::isdigit(input.Peek())) {
+      input.Advance();
     }
   };
 
-  if (input.peek() == '-') {
-    read_char();
+  if (input.Peek() == '-') {
+    input.Advance();
   }
   // Парсим целую часть числа
-  if (input.peek() == '0') {
-    read_char();
+  if (input.Peek() == '0') {
+    input.Advance();
     // После 0 в JSON не могут идти другие цифры
   } else {
     read_digits();
@@ -152,41 +347,43 @@ Node LoadNumber(std::istream &input) {
 
   bool is_int = true;
   // Парсим дробную часть числа
-  if (input.peek() == '.') {
-    read_char();
+  if (input.Peek() == '.') {
+    input.Advance();
     read_digits();
     is_int = false;
   }
 
   // Парсим экспоненциальную часть числа
-  if (int ch = input.peek(); ch == 'e' || ch == 'E') {
-    read_char();
-    if (ch = input.peek(); ch == '+' || ch == '-') {
-      read_char();
+  if (int ch = input.Peek(); ch == 'e' || ch == 'E') {
+    input.Advance();
+    if (ch = input.Peek(); ch == '+' || ch == '-') {
+      input.Advance();
     }
     read_digits();
     is_int = false;
   }
 
-  try {
-    if (is_int) {
-      // Сначала пробуем преобразовать строку в int
-      try {
-        return std::stoi(parsed_num);
-      } catch (...) {
-        // В случае неудачи, например, при переполнении
-        // код ниже попробует преобразовать строку в double
-      }
+  // Число уже проверено по грамматике JSON, from_chars разбирает его целиком без копирования
+  const std::string_view parsed_num = input.FinishToken();
+  const char *begin = parsed_num.data();
+  const char *end = begin + parsed_num.size();
+  if (is_int) {
+    // Сначала пробуем преобразовать число в int, при переполнении код ниже преобразует его в double
+    int value;
+    if (const auto [ptr, ec] = std::from_chars(begin, end, value); ec == std::errc() && ptr == end) {
+      return value;
     }
-    return std::stod(parsed_num);
-  } catch (...) {
-    throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
   }
+  double value;
+  if (const auto [ptr, ec] = std::from_chars(begin, end, value); ec == std::errc() && ptr == end) {
+    return value;
+  }
+  throw ParsingError("Failed to convert "s + std::string(parsed_num) + " to number"s);
 }
 
-Node LoadNode(std::istream &input) {
+Node LoadNode(Input &input) {
   char c;
-  if (!(input >> c)) {
+  if (!input.ReadSignificant(c)) {
     throw ParsingError("Unexpected EOF"s);
   }
   switch (c) {
@@ -201,15 +398,79 @@ Node LoadNode(std::istream &input) {
       // В данном случае, встретив t или f, переходим к попытке парсинга
       // литералов true либо false
       [[fallthrough]];
-    case 'f':input.putback(c);
+    case 'f':input.PutBack();
       return LoadBool(input);
-    case 'n':input.putback(c);
+    case 'n':input.PutBack();
       return LoadNull(input);
-    default:input.putback(c);
+    default:input.PutBack();
       return LoadNumber(input);
   }
 }
 
+void ParseNode(Input &input, Handler &handler, std::string &buffer);
+
+// Разбор массива и словаря повторяет LoadArray и LoadDict, но сообщает о значениях обработчику.
+// В buffer собираются строки, которые нельзя передать обработчику представлением буфера разбора
+void ParseArray(Input &input, Handler &handler, std::string &buffer) {
+  handler.StartArray();
+  for (char c;;) {
+    if (!input.ReadSignificant(c)) {
+      throw ParsingError("Array parsing error"s);
+    }
+    if (c == ']') {
+      break;
+    }
+    if (c != ',') {
+      input.PutBack();
+    }
+    ParseNode(input, handler, buffer);
+  }
+  handler.EndArray();
+}
+
+void ParseDict(Input &input, Handler &handler, std::string &buffer) {
+  handler.StartDict();
+  for (char c;;) {
+    if (!input.ReadSignificant(c)) {
+      throw ParsingError("Dictionary parsing error"s);
+    }
+    if (c == '}') {
+      break;
+    }
+    if (c == '"') {
+      // Ключ передаётся до двоеточия: поиск двоеточия может подкачать буфер, в который указывает ключ
+      handler.Key(LoadStringView(input, buffer));
+      if (input.ReadSignificant(c) && c == ':') {
+        ParseNode(input, handler, buffer);
+      } else {
+        throw ParsingError(": is expected but '"s + c + "' has been found"s);
+      }
+    } else if (c != ',') {
+      throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
+    }
+  }
+  handler.EndDict();
+}
+
+void ParseNode(Input &input, Handler &handler, std::string &buffer) {
+  char c;
+  if (!input.ReadSignificant(c)) {
+    throw ParsingError("Unexpected EOF"s);
+  }
+  switch (c) {
+    case '[':ParseArray(input, handler, buffer);
+      break;
+    case '{':ParseDict(input, handler, buffer);
+      break;
+    case '"':handler.String(LoadStringView(input, buffer));
+      break;
+    default:
+      // Числа и литералы разбираются так же, как при построении дерева
+      input.PutBack();
+      handler.Value(std::move(LoadNode(input).GetValue()));
+  }
+}
+
 struct PrintContext {
   std::ostream &out;
   int indent_step = 4;
@@ -326,8 +587,157 @@ void PrintNode(const Node &node, const PrintContext &ctx) {
 
 }  // namespace
 
+Document Load(std::string_view input) {
+  Input parser_input(input);
+  return Document{LoadNode(parser_input)};
+}
+
 Document Load(std::istream &input) {
-  return Document{LoadNode(input)};
+  Input parser_input(input);
+  return Document{LoadNode(parser_input)};
+}
+
+void Parse(std::string_view input, Handler &handler) {
+  Input parser_input(input);
+  std::string buffer;
+  ParseNode(parser_input, handler, buffer);
+}
+
+void Parse(std::istream &input, Handler &handler) {
+  Input parser_input(input);
+  std::string buffer;
+  ParseNode(parser_input, handler, buffer);
+}
+
+const ViewNode &ViewArray::at(size_t index) const {
+  if (index >= size_) {
+    throw std::out_of_range("Array index is out of range"s);
+  }
+  return items_[index];
+}
+
+const ViewMember *ViewDict::find(std::string_view key) const {
+  const ViewMember *it = std::lower_bound(begin(), end(), key, [](const ViewMember &member, std::string_view key) {
+    return member.first < key;
+  });
+  return it != end() && it->first == key ? it : end();
+}
+
+const ViewNode &ViewDict::at(std::string_view key) const {
+  if (const ViewMember *it = find(key); it != end()) {
+    return it->second;
+  }
+  throw std::out_of_range("Key '"s + std::string(key) + "' is not found"s);
+}
+
+uint32_t ViewNode::CheckSize(size_t size) {
+  if (size > std::numeric_limits<uint32_t>::max()) {
+    throw std::length_error("JSON value is too large"s);
+  }
+  return static_cast<uint32_t>(size);
+}
+
+void ViewBuilder::StartDict() {
+  StartContainer();
+}
+
+void ViewBuilder::Key(std::string_view key) {
+  key_ = StoreString(key);
+}
+
+void ViewBuilder::EndDict() {
+  const auto begin = items_.begin() + static_cast<std::ptrdiff_t>(item_starts_.back());
+  item_starts_.pop_back();
+  std::sort(begin, items_.end(), [](const ViewMember &lhs, const ViewMember &rhs) {
+    return lhs.first < rhs.first;
+  });
+  if (const auto it = std::adjacent_find(begin, items_.end(), [](const ViewMember &lhs, const ViewMember &rhs) {
+        return lhs.first == rhs.first;
+      }); it != items_.end()) {
+    throw ParsingError("Duplicate key '"s + std::string(it->first) + "' have been found");
+  }
+  const auto count = static_cast<size_t>(items_.end() - begin);
+  ViewMember *members = Allocate<ViewMember>(count);
+  std::uninitialized_copy(begin, items_.end(), members);
+  items_.erase(begin, items_.end());
+  FinishContainer(ViewDict(members, count));
+}
+
+void ViewBuilder::StartArray() {
+  StartContainer();
+}
+
+void ViewBuilder::EndArray() {
+  const auto begin = items_.begin() + static_cast<std::ptrdiff_t>(item_starts_.back());
+  item_starts_.pop_back();
+  const auto count = static_cast<size_t>(items_.end() - begin);
+  ViewNode *items = Allocate<ViewNode>(count);
+  for (auto it = begin; it != items_.end(); ++it) {
+    new(items + (it - begin)) ViewNode(it->second);
+  }
+  items_.erase(begin, items_.end());
+  FinishContainer(ViewArray(items, count));
+}
+
+void ViewBuilder::String(std::string_view value) {
+  AddNode(StoreString(value));
+}
+
+void ViewBuilder::Value(Node::Value value) {
+  std::visit([this](auto &value) {
+    using Type = std::decay_t<decltype(value)>;
+    if constexpr (std::is_same_v<Type, std::string>) {
+      String(value);
+    } else if constexpr (std::is_same_v<Type, Array> || std::is_same_v<Type, Dict>) {
+      throw std::logic_error("Arrays and dicts are built from events"s);
+    } else {
+      AddNode(value);
+    }
+  }, value);
+}
+
+ViewNode ViewBuilder::Build() {
+  return root_;
+}
+
+void ViewBuilder::StartContainer() {
+  // Место массива или словаря среди элементов родителя занимается сразу: пока он собирается, key_ меняется
+  items_.emplace_back(key_, ViewNode{});
+  item_starts_.push_back(items_.size());
+}
+
+void ViewBuilder::FinishContainer(ViewNode node) {
+  items_.back().second = node;
+  if (item_starts_.empty()) {
+    root_ = node;
+    items_.pop_back();
+  }
+}
+
+void ViewBuilder::AddNode(ViewNode node) {
+  if (item_starts_.empty()) {
+    root_ = node;
+  } else {
+    items_.emplace_back(key_, node);
+  }
+}
+
+std::string_view ViewBuilder::StoreString(std::string_view s) const {
+  const std::less<const char *> less;
+  if (!less(s.data(), text_.data()) && !less(text_.data() + text_.size(), s.data() + s.size())) {
+    return s;
+  }
+  char *data = Allocate<char>(s.size());
+  std::copy(s.begin(), s.end(), data);
+  return {data, s.size()};
+}
+
+ViewDocument::ViewDocument(std::string text)
+    : text_(std::make_unique<const std::string>(std::move(text))),
+      arena_(std::make_unique<std::pmr::monotonic_buffer_resource>()) {
+  ViewBuilder builder(*text_, *arena_);
+  Parse(*text_, builder);
+  root_ = builder.Build();
 }
 
 void Print(const Document &doc, std::ostream &output) {
@@ -1,8 +1,13 @@
 #pragma once
 
+#include <cstdint>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <memory_resource>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -140,8 +145,290 @@ inline bool operator!=(const Document &lhs, const Document &rhs) {
   return !(lhs == rhs);
 }
 
+// Разбирает первое JSON-значение текста, всё после него игнорируется. Поток читается блоками,
+// и прочитанное за концом значения из него уже извлечено
+Document Load(std::string_view input);
 Document Load(std::istream &input);
 
+/*
+ * Обработчик потокового разбора: Parse сообщает ему о значениях по мере чтения текста, не строя дерево,
+ * поэтому памяти нужно столько, сколько занимает то, что сохранит сам обработчик.
+ * События называются так же, как методы Builder, и приходят в том же порядке, в каком их вызывали бы,
+ * чтобы построить это значение, только строка приходит отдельным событием String. Повторы ключей словаря, в отличие от Load, не проверяются.
+ * Ключи и строки не копируются: они указывают в буфер разбора и действительны только до возврата из метода
+ */
+class Handler {
+ public:
+  virtual void StartDict() = 0;
+  virtual void Key(std::string_view key) = 0;
+  virtual void EndDict() = 0;
+  virtual void StartArray() = 0;
+  virtual void EndArray() = 0;
+  virtual void String(std::string_view value) = 0;
+  // Число, bool или null
+  virtual void Value(Node::Value value) = 0;
+
+ protected:
+  ~Handler() = default;
+};
+
+// Разбирает первое JSON-значение текста так же, как Load, и передаёт его обработчику по частям
+void Parse(std::string_view input, Handler &handler);
+void Parse(std::istream &input, Handler &handler);
+
+class ViewNode;
+class ViewArray;
+class ViewDict;
+using ViewMember = std::pair<std::string_view, ViewNode>;
+
+/*
+ * Узел дерева, разобранного без копирования строк: строки и ключи — представления текста, из которого
+ * дерево разобрано. Методы те же, что у Node, только AsString возвращает std::string_view, а AsArray и AsDict —
+ * ViewArray и ViewDict. Узел занимает 16 байт и не владеет ничем: массивы, словари и скопированные строки
+ * лежат в памяти, из которой его собрал ViewBuilder, и освобождаются вместе с ней
+ */
+class ViewNode final {
+ public:
+  ViewNode() = default;
+  ViewNode(std::nullptr_t) {}
+  ViewNode(bool value)
+      : type_(Type::BOOL), bool_(value) {}
+  ViewNode(int value)
+      : type_(Type::INT), int_(value) {}
+  ViewNode(double value)
+      : type_(Type::DOUBLE), double_(value) {}
+  ViewNode(std::string_view value)
+      : type_(Type::STRING), size_(CheckSize(value.size())), string_(value.data()) {}
+  // Без этого конструктора строковый литерал стал бы bool: указатель в bool — стандартное преобразование
+  ViewNode(const char *value)
+      : ViewNode(std::string_view(value)) {}
+  ViewNode(ViewArray value);
+  ViewNode(ViewDict value);
+
+  bool IsInt() const {
+    return type_ == Type::INT;
+  }
+  int AsInt() const {
+    using namespace std::literals;
+    if (!IsInt()) {
+      throw std::logic_error("Not an int"s);
+    }
+    return int_;
+  }
+
+  bool IsPureDouble() const {
+    return type_ == Type::DOUBLE;
+  }
+  bool IsDouble() const {
+    return IsInt() || IsPureDouble();
+  }
+  double AsDouble() const {
+    using namespace std::literals;
+    if (!IsDouble()) {
+      throw std::logic_error("Not a double"s);
+    }
+    return IsPureDouble() ? double_ : int_;
+  }
+
+  bool IsBool() const {
+    return type_ == Type::BOOL;
+  }
+  bool AsBool() const {
+    using namespace std::literals;
+    if (!IsBool()) {
+      throw std::logic_error("Not a bool"s);
+    }
+    return bool_;
+  }
+
+  bool IsNull() const {
+    return type_ == Type::NULL_VALUE;
+  }
+
+  bool IsArray() const {
+    return type_ == Type::ARRAY;
+  }
+  ViewArray AsArray() const;
+
+  bool IsString() const {
+    return type_ == Type::STRING;
+  }
+  std::string_view AsString() const {
+    using namespace std::literals;
+    if (!IsString()) {
+      throw std::logic_error("Not a string"s);
+    }
+    return {string_, size_};
+  }
+
+  bool IsDict() const {
+    return type_ == Type::DICT;
+  }
+  ViewDict AsDict() const;
+
+ private:
+  enum class Type : uint8_t { NULL_VALUE, ARRAY, DICT, BOOL, INT, DOUBLE, STRING };
+
+  static uint32_t CheckSize(size_t size);
+
+  Type type_ = Type::NULL_VALUE;
+  uint32_t size_ = 0;  // Длина строки, число элементов массива или пар словаря
+  union {
+    bool bool_;
+    int int_;
+    double double_ = 0;
+    const char *string_;
+    const ViewNode *items_;
+    const ViewMember *members_;
+  };
+};
+
+// Массив ViewNode: непрерывный участок памяти документа
+class ViewArray {
+ public:
+  ViewArray() = default;
+  ViewArray(const ViewNode *items, size_t size)
+      : items_(items), size_(size) {}
+
+  const ViewNode *begin() const {
+    return items_;
+  }
+  const ViewNode *end() const {
+    return items_ + size_;
+  }
+  size_t size() const {
+    return size_;
+  }
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  const ViewNode &operator[](size_t index) const {
+    return items_[index];
+  }
+  const ViewNode &at(size_t index) const;
+
+ private:
+  const ViewNode *items_ = nullptr;
+  size_t size_ = 0;
+};
+
+// Словарь ViewNode: непрерывный участок пар ключ — значение, упорядоченных по ключу, как в std::map.
+// Поиск по ключу — двоичный
+class ViewDict {
+ public:
+  ViewDict() = default;
+  ViewDict(const ViewMember *members, size_t size)
+      : members_(members), size_(size) {}
+
+  const ViewMember *begin() const {
+    return members_;
+  }
+  const ViewMember *end() const {
+    return members_ + size_;
+  }
+  size_t size() const {
+    return size_;
+  }
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  // Пара с ключом key или end()
+  const ViewMember *find(std::string_view key) const;
+  const ViewNode &at(std::string_view key) const;
+
+ private:
+  const ViewMember *members_ = nullptr;
+  size_t size_ = 0;
+};
+
+inline ViewNode::ViewNode(ViewArray value)
+    : type_(Type::ARRAY), size_(CheckSize(value.size())), items_(value.begin()) {}
+
+inline ViewNode::ViewNode(ViewDict value)
+    : type_(Type::DICT), size_(CheckSize(value.size())), members_(value.begin()) {}
+
+inline ViewArray ViewNode::AsArray() const {
+  using namespace std::literals;
+  if (!IsArray()) {
+    throw std::logic_error("Not an array"s);
+  }
+  return {items_, size_};
+}
+
+inline ViewDict ViewNode::AsDict() const {
+  using namespace std::literals;
+  if (!IsDict()) {
+    throw std::logic_error("Not a dict"s);
+  }
+  return {members_, size_};
+}
+
+/*
+ * Собирает ViewNode из событий разбора в memory. Строки, лежащие внутри text, берутся из него как есть,
+ * остальные — строки с escape-последовательностями и всё, что прочитано из потока, — копируются в memory.
+ * Элементы незаконченного массива или словаря копятся в общем буфере построителя и при закрытии переносятся
+ * в memory одним участком, поэтому на узел не приходится отдельного выделения памяти.
+ * Дерево действительно, пока живы text и memory. Повтор ключа словаря — ParsingError, как у Load
+ */
+class ViewBuilder final : public Handler {
+ public:
+  ViewBuilder(std::string_view text, std::pmr::memory_resource &memory)
+      : text_(text), memory_(&memory) {}
+
+  void StartDict() override;
+  void Key(std::string_view key) override;
+  void EndDict() override;
+  void StartArray() override;
+  void EndArray() override;
+  void String(std::string_view value) override;
+  void Value(Node::Value value) override;
+
+  // Возвращает собранное значение, после чего построитель готов собирать следующее
+  ViewNode Build();
+
+ private:
+  void StartContainer();
+  void FinishContainer(ViewNode node);
+  void AddNode(ViewNode node);
+  std::string_view StoreString(std::string_view s) const;
+
+  template<typename Item>
+  Item *Allocate(size_t count) const {
+    return count == 0 ? nullptr : static_cast<Item *>(memory_->allocate(count * sizeof(Item), alignof(Item)));
+  }
+
+  std::string_view text_;
+  std::pmr::memory_resource *memory_;
+  ViewNode root_;
+  // Элементы незаконченных массивов и словарей подряд от корня вглубь, у элементов массива ключ не важен.
+  // Сами незаконченные массивы и словари — пустые узлы перед своими элементами
+  std::vector<ViewMember> items_;
+  std::vector<size_t> item_starts_;  // Где в items_ начинаются элементы каждого незаконченного значения
+  std::string_view key_;
+};
+
+/*
+ * Документ, разобранный без копирования строк: хранит текст, в который указывают строки дерева, и арену,
+ * в которой лежат массивы, словари и строки с escape-последовательностями. Всё дерево освобождается
+ * вместе с ареной разом. Перемещение документа не перемещает ни текста, ни арены
+ */
+class ViewDocument {
+ public:
+  // Разбирает первое JSON-значение текста, как Load
+  explicit ViewDocument(std::string text);
+
+  const ViewNode &GetRoot() const {
+    return root_;
+  }
+
+ private:
+  std::unique_ptr<const std::string> text_;
+  std::unique_ptr<std::pmr::monotonic_buffer_resource> arena_;
+  ViewNode root_;
+};
+
 void Print(const Document &doc, std::ostream &output);
 
 }  // namespace json
\ No newline at end of file
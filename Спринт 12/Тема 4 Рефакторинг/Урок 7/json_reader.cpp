@@ -1,7 +1,10 @@
 #include "json_reader.h"
 
 #include <algorithm>
+#include <optional>
 #include <sstream>
+#include <stdexcept>
+#include <unordered_set>
 
 namespace {
 
@@ -26,41 +29,111 @@ void BuildRouteItem(json::Array &result, const router::RouteInfo::Waiting &item)
   Build());
 }
 
+// Число потоков или ёмкость кэша: отрицательное значение после приведения к size_t стало бы огромным
+size_t AsCount(const json::ViewNode &node, std::string_view name) {
+  const int value = node.AsInt();
+  if (value < 0) {
+    throw std::invalid_argument("Negative " + std::string(name) + ": " + std::to_string(value));
+  }
+  return static_cast<size_t>(value);
+}
+
+// Счётчики поиска по графу, которым найден маршрут
+json::Node BuildSearchStats(const graph::SearchStats &stats) {
+  return json::Builder{}.
+    StartDict().
+      Key("settled_vertices").Value(static_cast<int>(stats.settled_vertices)).
+      Key("relaxed_edges").Value(static_cast<int>(stats.relaxed_edges)).
+    EndDict().
+  Build();
+}
+
+// Попадания и промахи кэша маршрутов
+json::Node BuildRouteCacheStats(const router::Router::RouteCache::Stats &stats) {
+  return json::Builder{}.
+    StartDict().
+      Key("hits").Value(static_cast<int>(stats.hits)).
+      Key("misses").Value(static_cast<int>(stats.misses)).
+    EndDict().
+  Build();
+}
+
+// Маршрут в ответе на запрос множества Парето: время в пути, число поездок и участки пути
+json::Node BuildRoute(const router::RouteInfo &routing) {
+  json::Array items;
+  int bus_count = 0;
+  for (const auto &item : routing.items) {
+    std::visit([&items](const auto &item) { BuildRouteItem(items, item); }, item);
+    bus_count += std::holds_alternative<router::RouteInfo::Moving>(item);
+  }
+  return json::Builder{}.
+    StartDict().
+      Key("total_time").Value(routing.total_time.count()).
+      Key("bus_count").Value(bus_count).
+      Key("items").Value(items).
+    EndDict().
+  Build();
+}
+
 }
 
-void JsonReader::ParseBaseRequests(const json::Array &requests) {
+std::string_view JsonReader::StoreStopName(std::string_view name) {
+  if (const auto it = stop_names_.find(name); it != stop_names_.end()) {
+    return *it;
+  }
+  return *stop_names_.insert(stop_name_storage_.emplace_back(name)).first;
+}
+
+void JsonReader::ParseBaseRequests(const json::ViewArray &requests) {
   for (const auto &request : requests) {
-    BaseRequestDescription request_description;
-    const auto &request_map = request.AsDict();
-    request_description.name = request_map.at("name").AsString();
-    if (request_map.at("type").AsString() == "Bus") {
-      request_description.type = TypeRequest::qRoute;
-      for (const auto &stop : request_map.at("stops").AsArray()) {
-        request_description.stops.push_back(stop.AsString());
-      }
-      request_description.is_roundtrip = request_map.at("is_roundtrip").AsBool();
-      if (!request_description.is_roundtrip) {
-        size_t i = request_description.stops.size() - 1;
-        while (i > 0) {
-          --i;
-          request_description.stops.push_back(request_description.stops.at(i));
-        }
+    ParseBaseRequest(request);
+  }
+}
+
+void JsonReader::ParseBaseRequest(const json::ViewNode &request) {
+  BaseRequestDescription request_description;
+  const auto &request_map = request.AsDict();
+  request_description.name = request_map.at("name").AsString();
+  if (request_map.at("type").AsString() == "Bus") {
+    request_description.type = TypeRequest::qRoute;
+    for (const auto &stop : request_map.at("stops").AsArray()) {
+      request_description.stops.push_back(StoreStopName(stop.AsString()));
+    }
+    request_description.is_roundtrip = request_map.at("is_roundtrip").AsBool();
+    // Расписание необязательно: интервал движения и время первого и последнего отправления в минутах
+    if (const auto it = request_map.find("headway"); it != request_map.end()) {
+      request_description.schedule.headway_ = it->second.AsDouble();
+      if (request_description.schedule.headway_ < 0) {
+        throw std::invalid_argument("Negative headway of route " + std::string(request_description.name));
       }
-    } else {
-      request_description.type = TypeRequest::qStop;
-      request_description.coordinates.lat = request_map.at("latitude").AsDouble();
-      request_description.coordinates.lng = request_map.at("longitude").AsDouble();
-      for (const auto &stop : request_map.at("road_distances").AsDict()) {
-        request_description.distances.insert({stop.first, stop.second.AsInt()});
+    }
+    if (const auto it = request_map.find("first_departure"); it != request_map.end()) {
+      request_description.schedule.first_departure_ = it->second.AsDouble();
+    }
+    if (const auto it = request_map.find("last_departure"); it != request_map.end()) {
+      request_description.schedule.last_departure_ = it->second.AsDouble();
+    }
+    if (!request_description.is_roundtrip) {
+      size_t i = request_description.stops.size() - 1;
+      while (i > 0) {
+        --i;
+        request_description.stops.push_back(request_description.stops.at(i));
       }
     }
-    base_requests_.push_back(std::move(request_description));
+  } else {
+    request_description.type = TypeRequest::qStop;
+    request_description.coordinates.lat = request_map.at("latitude").AsDouble();
+    request_description.coordinates.lng = request_map.at("longitude").AsDouble();
+    for (const auto &stop : request_map.at("road_distances").AsDict()) {
+      request_description.distances.insert({StoreStopName(stop.first), stop.second.AsInt()});
+    }
   }
+  base_requests_.push_back(std::move(request_description));
 }
 
-svg::Color SerializeColor(const json::Node &request) {
+svg::Color SerializeColor(const json::ViewNode &request) {
   if (request.IsString()) {
-    return request.AsString();
+    return std::string(request.AsString());
   }
 
   if (request.IsArray()) {
@@ -81,7 +154,7 @@ svg::Color SerializeColor(const json::Node &request) {
   return svg::NoneColor;
 }
 
-void JsonReader::ParseRenderSettings(const json::Dict &request) {
+void JsonReader::ParseRenderSettings(const json::ViewDict &request) {
   render_settings_.width_ = request.at("width").AsDouble();
   render_settings_.height_ = request.at("height").AsDouble();
 
@@ -110,13 +183,13 @@ void JsonReader::ParseRenderSettings(const json::Dict &request) {
   }
 }
 
-void JsonReader::ParseStatRequests(const json::Array &requests) {
+void JsonReader::ParseStatRequests(const json::ViewArray &requests) {
   for (const auto &request : requests) {
     StatRequestDescription new_request;
     const auto &request_map = request.AsDict();
     new_request.id = request_map.at("id").AsInt();
 
-    const auto &type_request = request_map.at("type").AsString();
+    const auto type_request = request_map.at("type").AsString();
     if (type_request == "Bus") {
       new_request.type = TypeRequest::qRoute;
       new_request.name = request_map.at("name").AsString();
@@ -129,54 +202,266 @@ void JsonReader::ParseStatRequests(const json::Array &requests) {
       new_request.type = TypeRequest::qPath;
       new_request.path_from = request_map.at("from").AsString();
       new_request.path_to = request_map.at("to").AsString();
+      if (const auto it = request_map.find("departure_time"); it != request_map.end()) {
+        new_request.departure_time = router::Minutes(it->second.AsDouble());
+      }
+      if (const auto it = request_map.find("pareto"); it != request_map.end()) {
+        new_request.is_pareto = it->second.AsBool();
+      }
+      if (const auto it = request_map.find("search_stats"); it != request_map.end()) {
+        new_request.with_search_stats = it->second.AsBool();
+      }
+      if (const auto it = request_map.find("route_cache_stats"); it != request_map.end()) {
+        new_request.with_route_cache_stats = it->second.AsBool();
+      }
+      if (new_request.is_pareto && new_request.departure_time) {
+        throw std::invalid_argument("Pareto routes are not supported with departure_time");
+      }
+    } else if (type_request == "NearestStops") {
+      new_request.type = TypeRequest::qNearestStops;
+      new_request.point = {request_map.at("latitude").AsDouble(), request_map.at("longitude").AsDouble()};
+      if (const auto it = request_map.find("count"); it != request_map.end()) {
+        if (it->second.AsInt() < 0) {
+          throw std::invalid_argument("Negative count of nearest stops");
+        }
+        new_request.max_count = it->second.AsInt();
+      }
+      if (const auto it = request_map.find("radius"); it != request_map.end()) {
+        new_request.max_distance = it->second.AsDouble();
+      }
     }
     stat_requests_.push_back(std::move(new_request));
   }
 }
 
-void JsonReader::ParseRouterSettings(const json::Dict &requests) {
-  router_settings_.bus_wait_time = std::chrono::minutes(requests.at("bus_wait_time").AsInt());
+void JsonReader::ParseRouterSettings(const json::ViewDict &requests) {
+  // Нулевое ожидание годится для графа, а расписание без интервала движения отвергает запрос по расписанию
+  if (const int bus_wait_time = requests.at("bus_wait_time").AsInt(); bus_wait_time >= 0) {
+    router_settings_.bus_wait_time = std::chrono::minutes(bus_wait_time);
+  } else {
+    throw std::invalid_argument("Negative bus_wait_time: " + std::to_string(bus_wait_time));
+  }
   router_settings_.bus_velocity = requests.at("bus_velocity").AsDouble();
+  if (const auto it = requests.find("mode"); it != requests.end()) {
+    const auto mode = it->second.AsString();
+    if (mode == "all_pairs") {
+      router_settings_.mode = router::RoutingMode::AllPairs;
+    } else if (mode == "dijkstra") {
+      router_settings_.mode = router::RoutingMode::Dijkstra;
+    } else if (mode == "contraction_hierarchy") {
+      router_settings_.mode = router::RoutingMode::ContractionHierarchy;
+    } else if (mode == "a_star") {
+      router_settings_.mode = router::RoutingMode::AStar;
+    } else {
+      throw std::invalid_argument("Unknown routing mode: " + std::string(mode));
+    }
+  }
+  if (const auto it = requests.find("graph_model"); it != requests.end()) {
+    const auto model = it->second.AsString();
+    if (model == "complete") {
+      router_settings_.graph_model = router::GraphModel::Complete;
+    } else if (model == "chain") {
+      router_settings_.graph_model = router::GraphModel::Chain;
+    } else {
+      throw std::invalid_argument("Unknown graph model: " + std::string(model));
+    }
+  }
+  if (const auto it = requests.find("build_threads"); it != requests.end()) {
+    router_settings_.build_threads = AsCount(it->second, "build_threads");
+  }
+  if (const auto it = requests.find("query_threads"); it != requests.end()) {
+    router_settings_.query_threads = AsCount(it->second, "query_threads");
+  }
+  if (const auto it = requests.find("route_cache_capacity"); it != requests.end()) {
+    router_settings_.route_cache_capacity = AsCount(it->second, "route_cache_capacity");
+  }
+  if (const auto it = requests.find("route_cache_thread_safe"); it != requests.end()) {
+    router_settings_.is_route_cache_thread_safe = it->second.AsBool();
+  }
 }
 
-void JsonReader::ParseStream(std::istream &ist) {
-  node_ = json::Load(ist).GetRoot();
-  for (const auto &[key, value] : node_.AsDict()) {
-    if (key == "base_requests") {
-      ParseBaseRequests(value.AsArray());
-    } else if (key == "stat_requests") {
-      ParseStatRequests(value.AsArray());
-    } else if (key == "render_settings") {
-      ParseRenderSettings(value.AsDict());
-    } else if (key == "routing_settings") {
-      ParseRouterSettings(value.AsDict());
+void JsonReader::ParseSerializationSettings(const json::ViewDict &requests) {
+  serialization_settings_.file = requests.at("file").AsString();
+}
+
+/*
+ * Собирает из событий разбора деревья только для разделов корневого словаря, которые читает JsonReader,
+ * и передаёт их в методы разбора разделов. Массив base_requests не собирается целиком:
+ * дерево строится для каждого запроса отдельно и отбрасывается, как только запрос разобран
+ */
+class JsonReader::StreamHandler final : public json::Handler {
+ public:
+  explicit StreamHandler(JsonReader &reader)
+      : reader_(reader) {}
+
+  void StartDict() override {
+    if (depth_ == 0) {
+      ++depth_;
+      return;
+    }
+    BeginValue();
+    if (is_building_) {
+      value_builder_.StartDict();
+    }
+    ++depth_;
+  }
+
+  void Key(std::string_view key) override {
+    if (depth_ == 1) {
+      section_ = key;
+      // Разбор событиями не проверяет повторы ключей, а повтор раздела Load отверг бы
+      if (!sections_.insert(section_).second) {
+        throw json::ParsingError("Duplicate key '" + section_ + "' have been found");
+      }
+    } else if (is_building_) {
+      value_builder_.Key(key);
+    }
+  }
+
+  void EndDict() override {
+    --depth_;
+    if (is_building_) {
+      value_builder_.EndDict();
+      EndValue();
+    }
+  }
+
+  void StartArray() override {
+    CheckRoot();
+    if (depth_ == 1 && section_ == "base_requests") {
+      is_base_requests_ = true;
+      ++depth_;
+      return;
+    }
+    BeginValue();
+    if (is_building_) {
+      value_builder_.StartArray();
+    }
+    ++depth_;
+  }
+
+  void EndArray() override {
+    --depth_;
+    if (is_building_) {
+      value_builder_.EndArray();
+      EndValue();
+    } else if (depth_ == 1) {
+      is_base_requests_ = false;
+    }
+  }
+
+  void String(std::string_view value) override {
+    CheckRoot();
+    BeginValue();
+    if (is_building_) {
+      value_builder_.String(value);
+      EndValue();
+    }
+  }
+
+  void Value(json::Node::Value value) override {
+    CheckRoot();
+    BeginValue();
+    if (is_building_) {
+      value_builder_.Value(std::move(value));
+      EndValue();
+    }
+  }
+
+ private:
+  void CheckRoot() const {
+    if (depth_ == 0) {
+      throw std::logic_error("Not a dict");
+    }
+  }
+
+  // Начинает собирать дерево, если значение — нужный раздел или очередной запрос base_requests
+  void BeginValue() {
+    if (is_building_) {
+      return;
+    }
+    const bool is_section = depth_ == 1
+        && (section_ == "base_requests" || section_ == "stat_requests" || section_ == "render_settings"
+            || section_ == "routing_settings" || section_ == "serialization_settings");
+    if (is_section || (depth_ == 2 && is_base_requests_)) {
+      is_building_ = true;
+      value_depth_ = depth_;
+    }
+  }
+
+  // Передаёт собранное дерево на разбор, если значение закончилось
+  void EndValue() {
+    if (depth_ != value_depth_) {
+      return;
+    }
+    is_building_ = false;
+    ParseValue(value_builder_.Build());
+    // Разобранное значение больше не нужно: его память целиком переиспользуется следующим значением
+    value_memory_.release();
+  }
+
+  void ParseValue(const json::ViewNode &value) {
+    if (is_base_requests_) {
+      reader_.ParseBaseRequest(value);
+    } else if (section_ == "base_requests") {
+      reader_.ParseBaseRequests(value.AsArray());
+    } else if (section_ == "stat_requests") {
+      reader_.ParseStatRequests(value.AsArray());
+    } else if (section_ == "render_settings") {
+      reader_.ParseRenderSettings(value.AsDict());
+    } else if (section_ == "routing_settings") {
+      reader_.ParseRouterSettings(value.AsDict());
+    } else {
+      reader_.ParseSerializationSettings(value.AsDict());
     }
   }
+
+  JsonReader &reader_;
+  size_t depth_ = 0;  // Вложенность текущего места в тексте: 1 — внутри корневого словаря
+  std::string section_;
+  std::unordered_set<std::string> sections_;  // Уже встреченные ключи корневого словаря
+  bool is_base_requests_ = false;  // Внутри массива base_requests
+  // Узлы собираемого значения и его строки: поток не хранится целиком, поэтому копируются все строки
+  std::pmr::monotonic_buffer_resource value_memory_;
+  json::ViewBuilder value_builder_{{}, value_memory_};
+  bool is_building_ = false;
+  size_t value_depth_ = 0;
+};
+
+void JsonReader::ParseStream(std::istream &ist) {
+  StreamHandler handler(*this);
+  json::Parse(ist, handler);
 }
 
 void JsonReader::FillCatalogue(tc::TransportCatalogue &catalogue) const {
-  std::vector sorted_commands(base_requests_.begin(), base_requests_.end());
+  // Сортируются указатели, а не сами описания: копия каждого описания — это копии его названий и списков
+  std::vector<const BaseRequestDescription *> sorted_commands;
+  sorted_commands.reserve(base_requests_.size());
+  for (const auto &command : base_requests_) {
+    sorted_commands.push_back(&command);
+  }
   std::sort(sorted_commands.begin(),
             sorted_commands.end(),
-            [](const BaseRequestDescription &lhs, const BaseRequestDescription &rhs) {
-              return lhs.type > rhs.type;
+            [](const BaseRequestDescription *lhs, const BaseRequestDescription *rhs) {
+              return lhs->type > rhs->type;
             });
 
-  for (const auto &command : sorted_commands) {
-    if (command.type == TypeRequest::qStop) {
-      catalogue.AddStop(command.name, command.coordinates);
-    } else if (command.type == TypeRequest::qRoute) {
-      catalogue.AddRoute(command.name, command.stops, command.is_roundtrip);
+  for (const auto *command : sorted_commands) {
+    if (command->type == TypeRequest::qStop) {
+      catalogue.AddStop(command->name, command->coordinates);
+    } else if (command->type == TypeRequest::qRoute) {
+      catalogue.AddRoute(command->name, command->stops, command->is_roundtrip, command->schedule);
     }
   }
-  for (const auto &command : sorted_commands) {
-    if (command.type == TypeRequest::qStop) {
-      for (const auto distance : command.distances) {
-        catalogue.SetDistance({catalogue.GetStop(command.name), catalogue.GetStop(distance.first)},
-                              static_cast<size_t>(distance.second));
+  for (const auto *command : sorted_commands) {
+    if (command->type == TypeRequest::qStop) {
+      const tc::Stop *from = catalogue.GetStop(command->name);
+      for (const auto &[to_name, distance] : command->distances) {
+        catalogue.SetDistance({from, catalogue.GetStop(to_name)}, static_cast<size_t>(distance));
       }
     }
   }
+  catalogue.Finalize();
 }
 
 const renderer::Params &JsonReader::FillRenderSettings() const {
@@ -187,10 +472,26 @@ const router::Params &JsonReader::FillRouterSettings() const {
   return router_settings_;
 }
 
+const serialization::Settings &JsonReader::FillSerializationSettings() const {
+  return serialization_settings_;
+}
+
 void JsonReader::ParseRequests(const RequestHandler &handler, std::ostream &out) const {
+  // Запросы маршрутов обрабатываются одной пачкой, чтобы запросы из одной остановки делили общий поиск.
+  // Запросы с временем отправления и запросы множества Парето ищутся по одному
+  std::vector<router::Router::RouteQuery> route_queries;
+  for (const auto &request : stat_requests_) {
+    if (request.type == TypeRequest::qPath && !request.departure_time && !request.is_pareto) {
+      route_queries.emplace_back(request.path_from, request.path_to);
+    }
+  }
+  const auto routes = handler.FindRoutes(route_queries, router_settings_.query_threads);
+  auto next_route = routes.begin();
+
   std::stringstream ss;
   json::Array result;
-  for (const auto &[id, type, name, from, to] : stat_requests_) {
+  for (const auto &[id, type, name, from, to, departure_time, is_pareto, with_search_stats, with_route_cache_stats,
+                    point, max_count, max_distance] : stat_requests_) {
     switch (type) {
       case TypeRequest::qRoute:
         try {
@@ -243,21 +544,65 @@ void JsonReader::ParseRequests(const RequestHandler &handler, std::ostream &out)
           EndDict().
         Build());
         break;
-      case TypeRequest::qPath:
-        try {
-          const auto &routing = handler.FindRoute(from, to);
-          json::Array items;
-          for (const auto &item : routing.items) {
-            std::visit([&items](const auto &item) { BuildRouteItem(items, item); }, item);
+      case TypeRequest::qPath: {
+        if (is_pareto) {
+          std::vector<router::RouteInfo> pareto_routings;
+          try {
+            pareto_routings = handler.FindParetoRoutes(from, to);
+          } catch (const std::out_of_range &) {
+          } catch (const router::GraphError &) {
+          }
+          if (pareto_routings.empty()) {
+            result.emplace_back(json::Builder{}.
+              StartDict().
+                Key("request_id").Value(id).
+                Key("error_message").Value("not found").
+              EndDict().
+            Build());
+            break;
+          }
+          json::Array routes;
+          for (const auto &routing : pareto_routings) {
+            routes.emplace_back(BuildRoute(routing));
           }
           result.emplace_back(json::Builder{}.
             StartDict().
               Key("request_id").Value(id).
-              Key("total_time").Value(routing.total_time.count()).
-              Key("items").Value(items).
+              Key("routes").Value(routes).
             EndDict().
           Build());
-        } catch (const std::exception &) {
+          break;
+        }
+        std::optional<router::RouteInfo> timed_routing;
+        if (departure_time) {
+          try {
+            timed_routing = handler.FindRoute(from, to, *departure_time);
+          } catch (const std::invalid_argument &) {
+            // Расписание не строится: у маршрута без своего расписания нулевой интервал bus_wait_time
+          } catch (const std::out_of_range &) {
+          } catch (const router::GraphError &) {
+          }
+        }
+        if (const auto &routing = departure_time ? timed_routing : *next_route++) {
+          json::Array items;
+          for (const auto &item : routing->items) {
+            std::visit([&items](const auto &item) { BuildRouteItem(items, item); }, item);
+          }
+          json::Builder response;
+          response.
+            StartDict().
+              Key("request_id").Value(id).
+              Key("total_time").Value(routing->total_time.count()).
+              Key("items").Value(items);
+          if (with_search_stats) {
+            response.Key("search_stats").Value(BuildSearchStats(routing->search_stats).GetValue());
+          }
+          if (with_route_cache_stats) {
+            // Маршруты без времени отправления найдены одной пачкой до первого ответа, счётчики учитывают их все
+            response.Key("route_cache").Value(BuildRouteCacheStats(handler.GetRouteCacheStats()).GetValue());
+          }
+          result.emplace_back(response.EndDict().Build());
+        } else {
           result.emplace_back(json::Builder{}.
               StartDict().
               Key("request_id").Value(id).
@@ -266,6 +611,25 @@ void JsonReader::ParseRequests(const RequestHandler &handler, std::ostream &out)
               Build());
         }
         break;
+      }
+      case TypeRequest::qNearestStops: {
+        json::Array stops;
+        for (const auto &[stop, distance] : handler.FindNearbyStops(point, max_count, max_distance)) {
+          stops.emplace_back(json::Builder{}.
+            StartDict().
+              Key("name").Value(std::string(stop->name_)).
+              Key("distance").Value(distance).
+            EndDict().
+          Build());
+        }
+        result.emplace_back(json::Builder{}.
+          StartDict().
+            Key("request_id").Value(id).
+            Key("stops").Value(stops).
+          EndDict().
+        Build());
+        break;
+      }
       default:
         // Недостижимая ветка
         __builtin_unreachable();
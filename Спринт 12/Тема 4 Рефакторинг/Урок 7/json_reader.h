@@ -2,16 +2,22 @@
 
 #include "json_builder.h"
 #include "map_renderer.h"
+#include "serialization.h"
 #include "transport_catalogue.h"
 #include "transport_router.h"
 #include "request_handler.h"
 
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_set>
 #include <vector>
 
 class JsonReader {
  public:
   /**
-   * Парсит входящий поток и заполняет массивы base_requests_
+   * Парсит входящий поток и заполняет массивы base_requests_. Дерево JSON целиком не строится:
+   * каждый запрос base_requests разбирается отдельно, как только прочитан
    */
   void ParseStream(std::istream &ist);
 
@@ -30,6 +36,11 @@ class JsonReader {
    */
   const router::Params &FillRouterSettings() const;
 
+  /**
+   * Возвращает настройки сохранения транспортной базы в снимок
+   */
+  const serialization::Settings &FillSerializationSettings() const;
+
   /**
    * Выводит данные в поток.
    * В качестве аргументов требует RequestHandler, являющийся оболочкой между системами "Каталог" и "Рендер"
@@ -37,15 +48,24 @@ class JsonReader {
   void ParseRequests(const RequestHandler &handler, std::ostream &out) const;
 
  private:
-  void ParseBaseRequests(const json::Array &requests);
-  void ParseStatRequests(const json::Array &requests);
-  void ParseRenderSettings(const json::Dict &requests);
-  void ParseRouterSettings(const json::Dict &requests);
+  class StreamHandler;
+
+  void ParseBaseRequests(const json::ViewArray &requests);
+  void ParseBaseRequest(const json::ViewNode &request);
+  void ParseStatRequests(const json::ViewArray &requests);
+  void ParseRenderSettings(const json::ViewDict &requests);
+  void ParseRouterSettings(const json::ViewDict &requests);
+  void ParseSerializationSettings(const json::ViewDict &requests);
 
-  json::Node node_ = nullptr;
+  // Названия остановок из base_requests, на которые указывают списки остановок и расстояний в запросах.
+  // Поиск уже сохранённого названия не копирует его
+  std::string_view StoreStopName(std::string_view name);
 
+  std::deque<std::string> stop_name_storage_;
+  std::unordered_set<std::string_view> stop_names_;
   std::vector<BaseRequestDescription> base_requests_;
   std::vector<StatRequestDescription> stat_requests_;
   renderer::Params render_settings_;
   router::Params router_settings_;
+  serialization::Settings serialization_settings_;
 };
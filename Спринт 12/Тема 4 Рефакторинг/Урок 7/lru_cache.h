@@ -0,0 +1,88 @@
+#pragma once
+
+#include <functional>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace router {
+
+/*
+ * Кэш ограниченного размера, который при переполнении вытесняет запись, дольше всех не использовавшуюся.
+ * Поиск и добавление работают за O(1). В потокобезопасном режиме все операции выполняются под мьютексом,
+ * иначе кэш можно использовать только из одного потока
+ */
+template<typename Key, typename Value, typename Hash = std::hash<Key>>
+class LruCache {
+ public:
+  struct Stats {
+    size_t hits = 0;
+    size_t misses = 0;
+  };
+
+  LruCache(size_t capacity, bool is_thread_safe)
+      : capacity_(capacity), is_thread_safe_(is_thread_safe) {}
+
+  // Копирует значение в value и возвращает true, если ключ есть в кэше
+  bool Find(const Key &key, Value &value) {
+    auto lock = Lock();
+    const auto it = positions_.find(key);
+    if (it == positions_.end()) {
+      ++stats_.misses;
+      return false;
+    }
+    ++stats_.hits;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    value = it->second->second;
+    return true;
+  }
+
+  void Put(const Key &key, Value value) {
+    if (capacity_ == 0) {
+      return;
+    }
+    auto lock = Lock();
+    if (const auto it = positions_.find(key); it != positions_.end()) {
+      it->second->second = std::move(value);
+      entries_.splice(entries_.begin(), entries_, it->second);
+      return;
+    }
+    if (entries_.size() == capacity_) {
+      positions_.erase(entries_.back().first);
+      entries_.pop_back();
+    }
+    entries_.emplace_front(key, std::move(value));
+    positions_.emplace(key, entries_.begin());
+  }
+
+  // Удаляет все записи, счётчики попаданий и промахов сохраняются
+  void Clear() {
+    auto lock = Lock();
+    positions_.clear();
+    entries_.clear();
+  }
+
+  Stats GetStats() const {
+    auto lock = Lock();
+    return stats_;
+  }
+
+ private:
+  using Entry = std::pair<Key, Value>;
+
+  std::unique_lock<std::mutex> Lock() const {
+    return is_thread_safe_ ? std::unique_lock(mutex_) : std::unique_lock<std::mutex>();
+  }
+
+  const size_t capacity_;
+  const bool is_thread_safe_;
+  mutable std::mutex mutex_;
+
+  // Записи от недавно использованных к давно не использованным
+  std::list<Entry> entries_;
+  std::unordered_map<Key, typename std::list<Entry>::iterator, Hash> positions_;
+  Stats stats_;
+};
+
+}  // namespace router
@@ -1,12 +1,21 @@
 #include <iostream>
+#include <string_view>
 
 #include "json_reader.h"
+#include "serialization.h"
 
 using namespace std;
 
 using namespace tc;
 
-int main() {
+namespace {
+
+void PrintUsage(std::ostream &stream = std::cerr) {
+  stream << "Usage: transport_catalogue [make_base|process_requests]\n"sv;
+}
+
+// Строит справочник и маршрутизатор по base_requests и отвечает на stat_requests за один запуск
+void ProcessAll() {
   TransportCatalogue catalogue;
   JsonReader reader;
 
@@ -19,6 +28,53 @@ int main() {
   router::Router transport_router(router_settings, catalogue);
   RequestHandler handler(catalogue, map_renderer, transport_router);
   reader.ParseRequests(handler, std::cout);
+}
+
+// Строит справочник и маршрутизатор по base_requests и сохраняет их в снимок
+void MakeBase() {
+  TransportCatalogue catalogue;
+  JsonReader reader;
+
+  reader.ParseStream(std::cin);
+  reader.FillCatalogue(catalogue);
+  router::Router transport_router(reader.FillRouterSettings(), catalogue);
+  serialization::SaveBase(reader.FillSerializationSettings(), catalogue, reader.FillRenderSettings(),
+                          transport_router);
+}
+
+// Отвечает на stat_requests по ранее сохранённому снимку, ничего не перестраивая
+void ProcessRequests() {
+  JsonReader reader;
+
+  reader.ParseStream(std::cin);
+  const serialization::LoadedBase base(reader.FillSerializationSettings());
+
+  renderer::MapRenderer map_renderer(base.GetRenderSettings());
+  RequestHandler handler(base.GetCatalogue(), map_renderer, base.GetRouter());
+  reader.ParseRequests(handler, std::cout);
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  if (argc == 1) {
+    ProcessAll();
+    return 0;
+  }
+  if (argc != 2) {
+    PrintUsage();
+    return 1;
+  }
+
+  const std::string_view mode(argv[1]);
+  if (mode == "make_base"sv) {
+    MakeBase();
+  } else if (mode == "process_requests"sv) {
+    ProcessRequests();
+  } else {
+    PrintUsage();
+    return 1;
+  }
 
   return 0;
-}
\ No newline at end of file
+}
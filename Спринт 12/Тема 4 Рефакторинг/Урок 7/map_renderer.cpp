@@ -48,7 +48,7 @@ void MapRenderer::GetRouteLabel(const std::vector<const tc::Route *> &routes,
 
     text.SetFontSize(params_.route_label_font_size_);
     text.SetFontFamily("Verdana").SetFontWeight("bold");
-    text.SetData(route->name_);
+    text.SetData(std::string(route->name_));
 
     if (color_count < (params_.color_palette_.size() - 1)) {
       ++color_count;
@@ -69,7 +69,7 @@ void MapRenderer::GetRouteLabel(const std::vector<const tc::Route *> &routes,
 
     underlayer.SetFontSize(params_.route_label_font_size_);
     underlayer.SetFontFamily("Verdana").SetFontWeight("bold");
-    underlayer.SetData(route->name_);
+    underlayer.SetData(std::string(route->name_));
 
     result.Add(underlayer);
     result.Add(text);
@@ -113,7 +113,7 @@ void MapRenderer::GetStopsLabels(const std::vector<const tc::Stop *> &stops,
     text.SetOffset({params_.stop_label_offset_.first,
                     params_.stop_label_offset_.second});
     text.SetFontSize(params_.stop_label_font_size_).SetFontFamily("Verdana");
-    text.SetData(stop->name_);
+    text.SetData(std::string(stop->name_));
 
     underlayer.SetFillColor(params_.underlayer_color_);
     underlayer.SetStrokeColor(params_.underlayer_color_);
@@ -125,7 +125,7 @@ void MapRenderer::GetStopsLabels(const std::vector<const tc::Stop *> &stops,
     underlayer.SetOffset({params_.stop_label_offset_.first,
                           params_.stop_label_offset_.second});
     underlayer.SetFontSize(params_.stop_label_font_size_).SetFontFamily("Verdana");
-    underlayer.SetData(stop->name_);
+    underlayer.SetData(std::string(stop->name_));
 
     result.Add(underlayer);
     result.Add(text);
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <iterator>
 #include <string_view>
 #include <unordered_map>
@@ -21,6 +22,14 @@ class Range {
     return end_;
   }
 
+  bool empty() const {
+    return begin_ == end_;
+  }
+
+  size_t size() const {
+    return static_cast<size_t>(std::distance(begin_, end_));
+  }
+
  private:
   It begin_;
   It end_;
@@ -0,0 +1,206 @@
+#include "raptor_router.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+using namespace router;
+
+RaptorRouter::RaptorRouter(const tc::TransportCatalogue &catalogue, double wait_time, double bus_velocity)
+    : wait_time_(wait_time),
+      stops_(catalogue.GetAllStops()) {
+  const double meters_per_minute = bus_velocity * 1000 / 60.0;
+  route_offsets_.push_back(0);
+  for (const tc::Route *route : catalogue.GetSortedAllNonEmptyRoutes()) {
+    const auto &route_stops = route->stops_;
+    if (route_stops.size() <= 1) {
+      continue;
+    }
+    routes_.push_back(route);
+    double ride_time = 0;
+    for (size_t i = 0; i < route_stops.size(); ++i) {
+      if (i > 0) {
+        ride_time += catalogue.GetDistance({route_stops[i - 1], route_stops[i]}) / meters_per_minute;
+      }
+      route_stops_.push_back(route_stops[i]->id_);
+      route_ride_times_.push_back(ride_time);
+    }
+    route_offsets_.push_back(static_cast<uint32_t>(route_stops_.size()));
+  }
+  if (route_stops_.size() >= NONE) {
+    throw std::length_error("Too many route stops for RAPTOR");
+  }
+
+  // Маршруты через каждую остановку: сначала считаем, сколько их, затем раскладываем по местам.
+  // Остановка может встречаться на маршруте несколько раз, запоминается первое вхождение
+  std::vector<uint32_t> last_route(stops_.size(), NONE);
+  stop_route_offsets_.assign(stops_.size() + 1, 0);
+  for (uint32_t route = 0; route < routes_.size(); ++route) {
+    for (uint32_t i = route_offsets_[route]; i < route_offsets_[route + 1]; ++i) {
+      if (const uint32_t stop = route_stops_[i]; last_route[stop] != route) {
+        last_route[stop] = route;
+        ++stop_route_offsets_[stop + 1];
+      }
+    }
+  }
+  for (size_t stop = 0; stop < stops_.size(); ++stop) {
+    stop_route_offsets_[stop + 1] += stop_route_offsets_[stop];
+  }
+  stop_routes_.resize(stop_route_offsets_.back());
+  std::vector<uint32_t> fill_positions(stop_route_offsets_.begin(), stop_route_offsets_.end() - 1);
+  std::fill(last_route.begin(), last_route.end(), NONE);
+  for (uint32_t route = 0; route < routes_.size(); ++route) {
+    for (uint32_t i = route_offsets_[route]; i < route_offsets_[route + 1]; ++i) {
+      if (const uint32_t stop = route_stops_[i]; last_route[stop] != route) {
+        last_route[stop] = route;
+        stop_routes_[fill_positions[stop]++] = {route, i - route_offsets_[route]};
+      }
+    }
+  }
+}
+
+double RaptorRouter::GetWaitTime() const {
+  return wait_time_;
+}
+
+std::vector<RaptorRouter::Journey> RaptorRouter::FindParetoJourneys(const tc::Stop *from, const tc::Stop *to) const {
+  const uint32_t source = from->id_;
+  const uint32_t target = to->id_;
+  if (source == target) {
+    // Как и в графе маршрутизатора, остановка без маршрутов недостижима даже из самой себя
+    return from->routes_.empty() ? std::vector<Journey>{} : std::vector<Journey>{Journey{0, {}}};
+  }
+
+  constexpr double INF = std::numeric_limits<double>::infinity();
+  thread_local ScanState state;
+  state.Prepare(stops_.size(), routes_.size());
+  state.Reach(source, 0);
+  state.arrival_times[source] = 0;
+  state.is_marked[source] = 1;
+  state.marked_stops.push_back(source);
+
+  std::vector<Journey> journeys;
+  for (size_t round = 1; !state.marked_stops.empty(); ++round) {
+    // Маршруты через отмеченные остановки просматриваются с самой ранней отмеченной позиции
+    for (const uint32_t stop : state.marked_stops) {
+      state.is_marked[stop] = 0;
+      for (uint32_t i = stop_route_offsets_[stop]; i < stop_route_offsets_[stop + 1]; ++i) {
+        const auto [route, position] = stop_routes_[i];
+        uint32_t &first_position = state.route_first_positions[route];
+        if (first_position == NONE) {
+          state.queued_routes.push_back(route);
+        }
+        first_position = std::min(first_position, position);
+      }
+    }
+    state.marked_stops.clear();
+
+    // Посадки раунда — только с прибытий прошлых раундов, улучшения этого раунда копятся в best_arrival_times
+    // и переносятся в arrival_times после него
+    const double *prev_arrival_times = state.arrival_times.data();
+
+    for (const uint32_t route : state.queued_routes) {
+      const uint32_t begin = route_offsets_[route];
+      const uint32_t end = route_offsets_[route + 1];
+      // Прибытие на позицию i при посадке на позиции b равно prev_arrival[b] + wait + ride[i] - ride[b],
+      // поэтому достаточно помнить наименьшее prev_arrival[b] + wait - ride[b] среди пройденных позиций
+      double best_boarding = INF;
+      uint32_t boarding_position = NONE;
+      for (uint32_t i = begin + state.route_first_positions[route]; i < end; ++i) {
+        const uint32_t stop = route_stops_[i];
+        if (boarding_position != NONE) {
+          const double arrival_time = best_boarding + route_ride_times_[i];
+          if (arrival_time < std::min(state.best_arrival_times[stop], state.best_arrival_times[target])) {
+            state.Reach(stop, arrival_time);
+            state.round_labels[stop] = {route, boarding_position - begin, i - begin};
+            if (!state.is_marked[stop]) {
+              state.is_marked[stop] = 1;
+              state.marked_stops.push_back(stop);
+            }
+          }
+        }
+        if (const double boarding = prev_arrival_times[stop] + wait_time_ - route_ride_times_[i];
+            boarding < best_boarding) {
+          best_boarding = boarding;
+          boarding_position = i;
+        }
+      }
+      state.route_first_positions[route] = NONE;
+    }
+    state.queued_routes.clear();
+
+    for (const uint32_t stop : state.marked_stops) {
+      state.arrival_times[stop] = state.best_arrival_times[stop];
+      state.label_entries.push_back({state.round_labels[stop], static_cast<uint32_t>(round), state.last_entries[stop]});
+      state.last_entries[stop] = static_cast<uint32_t>(state.label_entries.size() - 1);
+    }
+    if (state.is_marked[target]) {
+      journeys.push_back(MakeJourney(state, source, target, round));
+    }
+  }
+  return journeys;
+}
+
+void RaptorRouter::ScanState::Prepare(size_t stop_count, size_t route_count) {
+  constexpr double INF = std::numeric_limits<double>::infinity();
+  // Массивы общие для всех маршрутизаторов потока: у другого маршрутизатора может быть больше остановок
+  if (arrival_times.size() < stop_count) {
+    arrival_times.resize(stop_count, INF);
+    best_arrival_times.resize(stop_count, INF);
+    round_labels.resize(stop_count);
+    last_entries.resize(stop_count, NONE);
+    is_marked.resize(stop_count, 0);
+  }
+  if (route_first_positions.size() < route_count) {
+    route_first_positions.resize(route_count, NONE);
+  }
+  // Законченный запрос сам снимает отметки и позиции, но прерванный исключением мог их оставить
+  for (const uint32_t stop : reached_stops) {
+    arrival_times[stop] = INF;
+    best_arrival_times[stop] = INF;
+    last_entries[stop] = NONE;
+  }
+  for (const uint32_t stop : marked_stops) {
+    is_marked[stop] = 0;
+  }
+  for (const uint32_t route : queued_routes) {
+    route_first_positions[route] = NONE;
+  }
+  reached_stops.clear();
+  label_entries.clear();
+  marked_stops.clear();
+  queued_routes.clear();
+}
+
+void RaptorRouter::ScanState::Reach(uint32_t stop, double arrival_time) {
+  if (best_arrival_times[stop] == std::numeric_limits<double>::infinity()) {
+    reached_stops.push_back(stop);
+  }
+  best_arrival_times[stop] = arrival_time;
+}
+
+RaptorRouter::Journey RaptorRouter::MakeJourney(const ScanState &state, uint32_t source, uint32_t target,
+                                                size_t round) const {
+  Journey journey{state.arrival_times[target], {}};
+  // Поездка раунда k начинается на остановке, прибытие на которую взято из раунда k - 1. Оно могло
+  // перейти туда из более раннего раунда без изменений, тогда метка ищется в том раунде, где оно найдено
+  for (uint32_t stop = target; stop != source;) {
+    uint32_t entry = state.last_entries[stop];
+    while (state.label_entries[entry].round > round) {
+      entry = state.label_entries[entry].prev_entry;
+    }
+    round = state.label_entries[entry].round;
+    const Label &label = state.label_entries[entry].label;
+    const uint32_t begin = route_offsets_[label.route];
+    journey.legs.push_back({
+        routes_[label.route],
+        stops_[route_stops_[begin + label.boarding_position]],
+        route_ride_times_[begin + label.alighting_position] - route_ride_times_[begin + label.boarding_position],
+        static_cast<size_t>(label.alighting_position - label.boarding_position),
+    });
+    stop = route_stops_[begin + label.boarding_position];
+    --round;
+  }
+  std::reverse(journey.legs.begin(), journey.legs.end());
+  return journey;
+}
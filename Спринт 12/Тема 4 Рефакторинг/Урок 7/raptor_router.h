@@ -0,0 +1,100 @@
+#pragma once
+
+#include "domain.h"
+#include "transport_catalogue.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace router {
+
+/*
+ * Многокритериальный поиск маршрутов по раундам (RAPTOR): раунд k находит самое раннее прибытие
+ * на каждую остановку ровно за k поездок, просматривая подряд только маршруты через остановки,
+ * улучшенные в прошлом раунде. Результат — множество Парето по паре (время в пути, число поездок).
+ * Модель та же, что у графа маршрутизатора: перед каждой посадкой ожидание wait_time, время поездки —
+ * расстояние, делённое на скорость. Остановки и маршруты хранятся в плоских массивах по плотным номерам
+ */
+class RaptorRouter {
+ public:
+  // Поездка на одном автобусе: ожидание на остановке посадки и steps_count пролётов
+  struct Leg {
+    const tc::Route *route;
+    const tc::Stop *boarding_stop;
+    double ride_time;
+    size_t steps_count;
+  };
+
+  struct Journey {
+    double total_time;
+    std::vector<Leg> legs;
+  };
+
+  // Время ожидания в минутах, скорость автобуса в км/ч
+  RaptorRouter(const tc::TransportCatalogue &catalogue, double wait_time, double bus_velocity);
+
+  /**
+   * Возвращает все оптимальные по Парето маршруты из from в to по возрастанию числа поездок:
+   * каждый следующий быстрее предыдущего. Пустой вектор — если маршрута нет
+   */
+  std::vector<Journey> FindParetoJourneys(const tc::Stop *from, const tc::Stop *to) const;
+
+  double GetWaitTime() const;
+
+ private:
+  static constexpr uint32_t NONE = static_cast<uint32_t>(-1);
+
+  // Маршрут, проходящий через остановку, и первая позиция остановки на нём
+  struct StopRoute {
+    uint32_t route;
+    uint32_t position;
+  };
+
+  // Как остановка достигнута в раунде: маршрут и позиции посадки и высадки на нём
+  struct Label {
+    uint32_t route = NONE;
+    uint32_t boarding_position = NONE;
+    uint32_t alighting_position = NONE;
+  };
+
+  // Метка остановки из раунда round и номер записи той же остановки из предыдущего раунда, где она улучшена
+  struct LabelEntry {
+    Label label;
+    uint32_t round;
+    uint32_t prev_entry;
+  };
+
+  // Рабочие массивы запроса, переиспользуются между запросами одного потока. Целиком они не очищаются:
+  // Prepare возвращает значения по умолчанию только остановкам и маршрутам, которых касался прошлый запрос
+  struct ScanState {
+    std::vector<double> arrival_times;       // Самое раннее прибытие за меньшее, чем в текущем раунде, число поездок
+    std::vector<double> best_arrival_times;  // То же вместе с улучшениями текущего раунда
+    std::vector<Label> round_labels;         // Метки остановок, улучшенных в текущем раунде
+    std::vector<uint32_t> last_entries;      // Последняя запись остановки в label_entries
+    std::vector<LabelEntry> label_entries;
+    std::vector<uint32_t> reached_stops;     // Остановки с заданным прибытием
+    std::vector<uint8_t> is_marked;
+    std::vector<uint32_t> marked_stops;
+    std::vector<uint32_t> route_first_positions;
+    std::vector<uint32_t> queued_routes;
+
+    void Prepare(size_t stop_count, size_t route_count);
+    void Reach(uint32_t stop, double arrival_time);
+  };
+
+  Journey MakeJourney(const ScanState &state, uint32_t source, uint32_t target, size_t round) const;
+
+  double wait_time_;
+  std::vector<const tc::Stop *> stops_;  // Все остановки справочника по номерам
+  std::vector<const tc::Route *> routes_;
+  // Остановки маршрута r и время в пути от его начала до каждой из них —
+  // в диапазоне [route_offsets_[r], route_offsets_[r + 1])
+  std::vector<uint32_t> route_offsets_;
+  std::vector<uint32_t> route_stops_;
+  std::vector<double> route_ride_times_;
+  // Маршруты через остановку s — в диапазоне [stop_route_offsets_[s], stop_route_offsets_[s + 1])
+  std::vector<uint32_t> stop_route_offsets_;
+  std::vector<StopRoute> stop_routes_;
+};
+
+}  // namespace router
@@ -4,7 +4,7 @@ RouteInfo RequestHandler::GetRouteInfo(std::string_view name) const {
   return db_.GetRouteInfo(name);
 }
 
-const std::set<std::string_view> &RequestHandler::GetRoutes(const std::string_view stop_name) const {
+TransportCatalogue::RouteNames RequestHandler::GetRoutes(const std::string_view stop_name) const {
   return db_.GetRoutes(stop_name);
 }
 
@@ -12,6 +12,29 @@ svg::Document RequestHandler::RenderMap() const {
   return renderer_.RenderSVG(db_.GetSortedAllNonEmptyRoutes(), db_.GetSortedAllNonEmptyStops());
 }
 
+std::vector<tc::NearbyStop> RequestHandler::FindNearbyStops(geo::Coordinates point, size_t max_count,
+                                                            double max_distance) const {
+  return db_.FindNearbyStops(point, max_count, max_distance);
+}
+
 router::RouteInfo RequestHandler::FindRoute(std::string_view from, std::string_view to) const {
     return router_.FindRoute(from, to);
 }
+
+router::RouteInfo RequestHandler::FindRoute(std::string_view from, std::string_view to,
+                                            router::Minutes departure_time) const {
+  return router_.FindRoute(from, to, departure_time);
+}
+
+std::vector<router::RouteInfo> RequestHandler::FindParetoRoutes(std::string_view from, std::string_view to) const {
+  return router_.FindParetoRoutes(from, to);
+}
+
+std::vector<std::optional<router::RouteInfo>> RequestHandler::FindRoutes(
+    const std::vector<router::Router::RouteQuery> &queries, size_t thread_count) const {
+  return router_.FindRoutes(queries, thread_count);
+}
+
+router::Router::RouteCache::Stats RequestHandler::GetRouteCacheStats() const {
+  return router_.GetRouteCacheStats();
+}
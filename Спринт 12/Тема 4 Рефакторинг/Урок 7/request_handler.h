@@ -4,6 +4,7 @@
 #include "transport_catalogue.h"
 #include "transport_router.h"
 
+#include <limits>
 #include <optional>
 #include <unordered_set>
 
@@ -18,7 +19,8 @@ enum class TypeRequest {
   qRoute,
   qStop,
   qMap,
-  qPath
+  qPath,
+  qNearestStops
 };
 
 struct BaseRequestDescription {
@@ -36,6 +38,7 @@ struct BaseRequestDescription {
   bool is_roundtrip;
   geo::Coordinates coordinates;
   std::map<std::string_view, int> distances;
+  tc::RouteSchedule schedule;
 };
 
 struct StatRequestDescription {
@@ -52,6 +55,14 @@ struct StatRequestDescription {
   std::string name;
   std::string path_from;
   std::string path_to;
+  std::optional<router::Minutes> departure_time;  // Для маршрута по расписанию, от начала суток
+  bool is_pareto = false;  // Нужны все оптимальные по Парето маршруты по времени и числу поездок
+  bool with_search_stats = false;  // Добавить в ответ счётчики поиска по графу
+  bool with_route_cache_stats = false;  // Добавить в ответ попадания и промахи кэша маршрутов на момент ответа
+  // Для поиска остановок рядом с точкой: сколько найти не больше и как далеко от точки, в метрах
+  geo::Coordinates point{};
+  size_t max_count = std::numeric_limits<size_t>::max();
+  double max_distance = std::numeric_limits<double>::infinity();
 };
 
 class RequestHandler {
@@ -61,12 +72,23 @@ class RequestHandler {
 
   RouteInfo GetRouteInfo(std::string_view name) const;
 
-  const std::set<std::string_view> &GetRoutes(std::string_view stop_name) const;
+  TransportCatalogue::RouteNames GetRoutes(std::string_view stop_name) const;
 
   svg::Document RenderMap() const;
 
+  std::vector<tc::NearbyStop> FindNearbyStops(geo::Coordinates point, size_t max_count, double max_distance) const;
+
   router::RouteInfo FindRoute(std::string_view from, std::string_view to) const;
 
+  router::RouteInfo FindRoute(std::string_view from, std::string_view to, router::Minutes departure_time) const;
+
+  std::vector<router::RouteInfo> FindParetoRoutes(std::string_view from, std::string_view to) const;
+
+  std::vector<std::optional<router::RouteInfo>> FindRoutes(const std::vector<router::Router::RouteQuery> &queries,
+                                                           size_t thread_count) const;
+
+  router::Router::RouteCache::Stats GetRouteCacheStats() const;
+
  private:
   const TransportCatalogue &db_;
   const renderer::MapRenderer &renderer_;
@@ -1,115 +1,426 @@
 #pragma once
 
 #include "graph.h"
+#include "snapshot.h"
 
 #include <algorithm>
 #include <cassert>
+#include <condition_variable>
 #include <cstdint>
+#include <functional>
 #include <iterator>
+#include <mutex>
 #include <optional>
+#include <queue>
 #include <stdexcept>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 namespace graph {
 
-template<typename Weight>
-class Router {
- private:
-  using Graph = DirectedWeightedGraph<Weight>;
+// Счётчики работы поиска по графу. Маршрутизаторы, которые не ищут по графу, оставляют их нулевыми
+struct SearchStats {
+  size_t settled_vertices = 0;  // Вершины, извлечённые из очереди с окончательным весом
+  size_t relaxed_edges = 0;     // Просмотренные рёбра этих вершин
+};
 
+/*
+ * Абстрактный базовый класс для всех реализаций поиска кратчайшего пути в графе.
+ * Позволяет транспортному маршрутизатору выбирать алгоритм в зависимости от настроек
+ */
+template<typename Weight>
+class RouterBase {
  public:
-  explicit Router(const Graph &graph);
-
   struct RouteInfo {
     Weight weight;
     std::vector <EdgeId> edges;
+    SearchStats stats{};
   };
 
-  std::optional <RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+  virtual ~RouterBase() = default;
 
+  virtual std::optional <RouteInfo> BuildRoute(VertexId from, VertexId to) const = 0;
+
+  /**
+   * Строит маршруты из from в каждую вершину targets, ответы идут в том же порядке, что и targets.
+   * Реализация по умолчанию строит маршруты по одному, алгоритмы с поиском по графу обходятся одним поиском
+   */
+  virtual std::vector <std::optional<RouteInfo>> BuildRoutes(VertexId from,
+                                                             const std::vector <VertexId> &targets) const {
+    std::vector <std::optional<RouteInfo>> routes;
+    routes.reserve(targets.size());
+    for (const VertexId to : targets) {
+      routes.push_back(BuildRoute(from, to));
+    }
+    return routes;
+  }
+
+  // Сохраняет предпосчитанные данные в снимок. Маршрутизаторам без предпосчёта сохранять нечего
+  virtual void Save(serialization::Writer &) const {}
+
+  /**
+   * Обновляют предпосчитанные данные после изменения графа: у ребра edge_id поменялся вес (old_weight — прежний)
+   * или в граф добавлены вершины и рёбра с номерами от first_new_edge. Возвращают false, если маршрутизатор
+   * не умеет обновляться по частям и его нужно построить заново. Нельзя вызывать одновременно с поиском маршрутов
+   */
+  virtual bool OnEdgeWeightChanged(EdgeId /*edge_id*/, Weight /*old_weight*/) {
+    return false;
+  }
+
+  virtual bool OnEdgesAdded(EdgeId /*first_new_edge*/) {
+    return false;
+  }
+};
+
+// Номер ребра в плоской таблице всех пар. Таблица строится только для графов, где номера рёбер умещаются в 32 бита
+using TableEdgeId = uint32_t;
+
+// Последнее ребро пути, которого нет, и пути из вершины в саму себя
+inline constexpr TableEdgeId TABLE_NO_ROUTE = static_cast<TableEdgeId>(-1);
+inline constexpr TableEdgeId TABLE_NO_EDGE = static_cast<TableEdgeId>(-2);
+
+/*
+ * Маршрутизатор, предпосчитывающий кратчайшие пути между всеми парами вершин алгоритмом Флойда — Уоршелла.
+ * Требует O(V^3) времени и O(V^2) памяти, зато отвечает на запрос без поиска по графу.
+ * Таблица плоская: два массива V * V по строкам — веса путей и последние рёбра путей (32-битные номера).
+ * Построение можно распараллелить: на каждом шаге алгоритма строки таблицы делятся между потоками.
+ * Изменения графа таблица учитывает по частям: уменьшение веса ребра — за O(V^2), увеличение — пересчётом
+ * алгоритмом Дейкстры только тех строк, чьё дерево кратчайших путей проходит через ребро
+ */
+template<typename Weight>
+class Router : public RouterBase<Weight> {
  private:
-  struct RouteInternalData {
-    Weight weight;
-    std::optional <EdgeId> prev_edge;
+  using Graph = DirectedWeightedGraph<Weight>;
+
+ public:
+  using typename RouterBase<Weight>::RouteInfo;
+
+  explicit Router(const Graph &graph, size_t thread_count = 1);
+
+  /**
+   * Берёт готовую таблицу, записанную методом Save. Таблица не копируется (обычно она лежит прямо
+   * в отображённом в память снимке), пока маршрутизатору не понадобится её обновить
+   */
+  Router(const Graph &graph, ranges::Range<const Weight *> weights, ranges::Range<const TableEdgeId *> prev_edges);
+
+  std::optional <RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+  // Записывает массив весов и массив рёбер таблицы
+  void Save(serialization::Writer &writer) const override;
+
+  bool OnEdgeWeightChanged(EdgeId edge_id, Weight old_weight) override;
+  bool OnEdgesAdded(EdgeId first_new_edge) override;
+
+ private:
+  // Точка синхронизации потоков между шагами алгоритма
+  class Barrier {
+   public:
+    explicit Barrier(size_t thread_count) : thread_count_(thread_count) {}
+
+    // Ждёт, пока до барьера дойдут все потоки. Возвращает false, если ожидание отменено
+    bool Wait() {
+      std::unique_lock lock(mutex_);
+      const size_t generation = generation_;
+      if (++waiting_count_ == thread_count_) {
+        waiting_count_ = 0;
+        ++generation_;
+        cv_.notify_all();
+      } else {
+        cv_.wait(lock, [this, generation] { return generation != generation_ || is_cancelled_; });
+      }
+      return !is_cancelled_;
+    }
+
+    // Отпускает ждущие потоки и все последующие ожидания, если до барьера уже не дойдут все потоки
+    void Cancel() {
+      std::lock_guard lock(mutex_);
+      is_cancelled_ = true;
+      cv_.notify_all();
+    }
+
+   private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    const size_t thread_count_;
+    size_t waiting_count_ = 0;
+    size_t generation_ = 0;
+    bool is_cancelled_ = false;
   };
-  using RoutesInternalData = std::vector <std::vector<std::optional < RouteInternalData>>>;
-
-  void InitializeRoutesInternalData(const Graph &graph) {
-    const size_t vertex_count = graph.GetVertexCount();
-    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-      routes_internal_data_[vertex][vertex] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
-      for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
-        const auto &edge = graph.GetEdge(edge_id);
-        if (edge.weight < ZERO_WEIGHT) {
-          throw std::domain_error("Edges' weights should be non-negative");
+
+  void InitializeTable() {
+    for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+      weights_[vertex * vertex_count_ + vertex] = ZERO_WEIGHT;
+      prev_edges_[vertex * vertex_count_ + vertex] = TABLE_NO_EDGE;
+      for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+        const auto &edge = graph_.GetEdge(edge_id);
+        CheckEdgeWeight(edge.weight);
+        const size_t cell = vertex * vertex_count_ + edge.to;
+        if (prev_edges_[cell] == TABLE_NO_ROUTE || weights_[cell] > edge.weight) {
+          weights_[cell] = edge.weight;
+          prev_edges_[cell] = static_cast<TableEdgeId>(edge_id);
         }
-        auto &route_internal_data = routes_internal_data_[vertex][edge.to];
-        if (!route_internal_data || route_internal_data->weight > edge.weight) {
-          route_internal_data = RouteInternalData{edge.weight, edge_id};
+      }
+    }
+  }
+
+  // Обновляет только строки [rows_begin, rows_end). Строка и столбец vertex_through на этом шаге
+  // не меняются, поэтому разные диапазоны строк можно обрабатывать параллельно без блокировок
+  void RelaxRowsThroughVertex(VertexId rows_begin, VertexId rows_end, VertexId vertex_through) {
+    const Weight *through_weights = weights_.data() + vertex_through * vertex_count_;
+    const TableEdgeId *through_edges = prev_edges_.data() + vertex_through * vertex_count_;
+    for (VertexId vertex_from = rows_begin; vertex_from < rows_end; ++vertex_from) {
+      Weight *row_weights = weights_.data() + vertex_from * vertex_count_;
+      TableEdgeId *row_edges = prev_edges_.data() + vertex_from * vertex_count_;
+      const TableEdgeId edge_from = row_edges[vertex_through];
+      if (edge_from == TABLE_NO_ROUTE) {
+        continue;
+      }
+      const Weight weight_from = row_weights[vertex_through];
+      for (VertexId vertex_to = 0; vertex_to < vertex_count_; ++vertex_to) {
+        const TableEdgeId edge_to = through_edges[vertex_to];
+        if (edge_to == TABLE_NO_ROUTE) {
+          continue;
+        }
+        const Weight candidate_weight = weight_from + through_weights[vertex_to];
+        if (row_edges[vertex_to] == TABLE_NO_ROUTE || candidate_weight < row_weights[vertex_to]) {
+          row_weights[vertex_to] = candidate_weight;
+          row_edges[vertex_to] = edge_to != TABLE_NO_EDGE ? edge_to : edge_from;
         }
       }
     }
   }
 
-  void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData &route_from,
-                  const RouteInternalData &route_to) {
-    auto &route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-    const Weight candidate_weight = route_from.weight + route_to.weight;
-    if (!route_relaxing || candidate_weight < route_relaxing->weight) {
-      route_relaxing = {candidate_weight, route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge};
+  // Улучшает пути, которые стали короче, если пройти через ребро edge_id. Веса рёбер неотрицательны,
+  // поэтому строка и столбец, через которые идёт улучшение, сами при этом не меняются
+  void RelaxThroughEdge(EdgeId edge_id) {
+    const auto &edge = graph_.GetEdge(edge_id);
+    const Weight *through_weights = weights_.data() + edge.to * vertex_count_;
+    const TableEdgeId *through_edges = prev_edges_.data() + edge.to * vertex_count_;
+    for (VertexId vertex_from = 0; vertex_from < vertex_count_; ++vertex_from) {
+      Weight *row_weights = weights_.data() + vertex_from * vertex_count_;
+      TableEdgeId *row_edges = prev_edges_.data() + vertex_from * vertex_count_;
+      if (row_edges[edge.from] == TABLE_NO_ROUTE) {
+        continue;
+      }
+      const Weight weight_from = row_weights[edge.from] + edge.weight;
+      for (VertexId vertex_to = 0; vertex_to < vertex_count_; ++vertex_to) {
+        const TableEdgeId edge_to = through_edges[vertex_to];
+        if (edge_to == TABLE_NO_ROUTE) {
+          continue;
+        }
+        const Weight candidate_weight = weight_from + through_weights[vertex_to];
+        if (row_edges[vertex_to] == TABLE_NO_ROUTE || candidate_weight < row_weights[vertex_to]) {
+          row_weights[vertex_to] = candidate_weight;
+          row_edges[vertex_to] = edge_to != TABLE_NO_EDGE ? edge_to : static_cast<TableEdgeId>(edge_id);
+        }
+      }
     }
   }
 
-  void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
-    for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-      if (const auto &route_from = routes_internal_data_[vertex_from][vertex_through]) {
-        for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-          if (const auto &route_to = routes_internal_data_[vertex_through][vertex_to]) {
-            RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
-          }
+  // Заново заполняет строку vertex_from алгоритмом Дейкстры по текущим весам рёбер
+  void RecomputeRow(VertexId vertex_from) {
+    Weight *row_weights = weights_.data() + vertex_from * vertex_count_;
+    TableEdgeId *row_edges = prev_edges_.data() + vertex_from * vertex_count_;
+    std::fill(row_edges, row_edges + vertex_count_, TABLE_NO_ROUTE);
+    row_weights[vertex_from] = ZERO_WEIGHT;
+    row_edges[vertex_from] = TABLE_NO_EDGE;
+
+    using QueueItem = std::pair<Weight, VertexId>;
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<>> queue;
+    queue.push({ZERO_WEIGHT, vertex_from});
+    while (!queue.empty()) {
+      const auto [weight, vertex] = queue.top();
+      queue.pop();
+      if (row_weights[vertex] < weight) {
+        continue;
+      }
+      graph_.ForEachIncidentEdge(vertex, [&, weight = weight](EdgeId edge_id, VertexId edge_to, Weight edge_weight) {
+        const Weight candidate_weight = weight + edge_weight;
+        if (row_edges[edge_to] == TABLE_NO_ROUTE || candidate_weight < row_weights[edge_to]) {
+          row_weights[edge_to] = candidate_weight;
+          row_edges[edge_to] = static_cast<TableEdgeId>(edge_id);
+          queue.push({candidate_weight, edge_to});
         }
+      });
+    }
+  }
+
+  // Переносит таблицу в собственные массивы под vertex_count вершин, новые вершины пока ни с чем не связаны
+  void ResizeTable(size_t vertex_count) {
+    std::vector<Weight> weights(vertex_count * vertex_count, ZERO_WEIGHT);
+    std::vector<TableEdgeId> prev_edges(vertex_count * vertex_count, TABLE_NO_ROUTE);
+    for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
+      if (vertex_from < vertex_count_) {
+        std::copy_n(weights_data_ + vertex_from * vertex_count_, vertex_count_,
+                    weights.begin() + vertex_from * vertex_count);
+        std::copy_n(prev_edges_data_ + vertex_from * vertex_count_, vertex_count_,
+                    prev_edges.begin() + vertex_from * vertex_count);
+      } else {
+        prev_edges[vertex_from * vertex_count + vertex_from] = TABLE_NO_EDGE;
       }
     }
+    weights_ = std::move(weights);
+    prev_edges_ = std::move(prev_edges);
+    vertex_count_ = vertex_count;
+    weights_data_ = weights_.data();
+    prev_edges_data_ = prev_edges_.data();
+  }
+
+  static void CheckEdgeWeight(Weight weight) {
+    if (weight < ZERO_WEIGHT) {
+      throw std::domain_error("Edges' weights should be non-negative");
+    }
+  }
+
+  void CheckEdgeCount() const {
+    if (graph_.GetEdgeCount() >= TABLE_NO_EDGE) {
+      throw std::length_error("Too many edges for the routes table");
+    }
   }
 
   static constexpr Weight
   ZERO_WEIGHT{};
   const Graph &graph_;
-  RoutesInternalData routes_internal_data_;
+  size_t vertex_count_;
+  // Вес пути from -> to лежит в weights_[from * vertex_count_ + to], последнее ребро — в prev_edges_ там же.
+  // Вес имеет смысл, только если ребро не TABLE_NO_ROUTE
+  std::vector<Weight> weights_;
+  std::vector<TableEdgeId> prev_edges_;
+  // Таблица, по которой отвечают запросы: собственные массивы или массивы снимка
+  const Weight *weights_data_ = nullptr;
+  const TableEdgeId *prev_edges_data_ = nullptr;
 };
 
 template<typename Weight>
-Router<Weight>::Router(const Graph &graph)
-    : graph_(graph), routes_internal_data_(graph.GetVertexCount(),
-                                           std::vector < std::optional
-                                               < RouteInternalData >> (graph.GetVertexCount())) {
-  InitializeRoutesInternalData(graph);
+Router<Weight>::Router(const Graph &graph, size_t thread_count)
+    : graph_(graph), vertex_count_(graph.GetVertexCount()) {
+  CheckEdgeCount();
+  weights_.assign(vertex_count_ * vertex_count_, ZERO_WEIGHT);
+  prev_edges_.assign(vertex_count_ * vertex_count_, TABLE_NO_ROUTE);
+  weights_data_ = weights_.data();
+  prev_edges_data_ = prev_edges_.data();
+  InitializeTable();
 
-  const size_t vertex_count = graph.GetVertexCount();
-  for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
-    RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+  const size_t vertex_count = vertex_count_;
+  // Потоков сверх числа ядер шагам с барьером только мешают
+  if (const size_t core_count = std::thread::hardware_concurrency(); core_count != 0) {
+    thread_count = std::min<size_t>(thread_count, core_count);
+  }
+  thread_count = std::clamp<size_t>(thread_count, 1, std::max<size_t>(vertex_count, 1));
+  if (thread_count == 1) {
+    for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
+      RelaxRowsThroughVertex(0, vertex_count, vertex_through);
+    }
+    return;
+  }
+
+  // Каждый поток отвечает за свой непрерывный диапазон строк таблицы. Порядок обновления каждой ячейки
+  // совпадает с последовательным вариантом, поэтому результат побитово тот же
+  Barrier barrier(thread_count);
+  auto relax_rows = [this, &barrier, vertex_count, thread_count](size_t thread_idx) {
+    const VertexId rows_begin = vertex_count * thread_idx / thread_count;
+    const VertexId rows_end = vertex_count * (thread_idx + 1) / thread_count;
+    for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
+      RelaxRowsThroughVertex(rows_begin, rows_end, vertex_through);
+      if (!barrier.Wait()) {
+        return;
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  workers.reserve(thread_count - 1);
+  try {
+    for (size_t thread_idx = 1; thread_idx < thread_count; ++thread_idx) {
+      workers.emplace_back(relax_rows, thread_idx);
+    }
+  } catch (...) {
+    // Строки незапущенных потоков считать некому: запущенные потоки отпускаются с барьера и дожидаются
+    barrier.Cancel();
+    for (auto &worker : workers) {
+      worker.join();
+    }
+    throw;
+  }
+  relax_rows(0);
+  for (auto &worker : workers) {
+    worker.join();
+  }
+}
+
+template<typename Weight>
+Router<Weight>::Router(const Graph &graph, ranges::Range<const Weight *> weights,
+                       ranges::Range<const TableEdgeId *> prev_edges)
+    : graph_(graph), vertex_count_(graph.GetVertexCount()),
+      weights_data_(weights.begin()), prev_edges_data_(prev_edges.begin()) {
+  const size_t cell_count = vertex_count_ * vertex_count_;
+  if (static_cast<size_t>(weights.end() - weights.begin()) != cell_count
+      || static_cast<size_t>(prev_edges.end() - prev_edges.begin()) != cell_count) {
+    throw std::invalid_argument("Routes table doesn't match the graph");
   }
 }
 
 template<typename Weight>
 std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
                                                                              VertexId to) const {
-  const auto &route_internal_data = routes_internal_data_.at(from).at(to);
-  if (!route_internal_data) {
+  if (from >= vertex_count_ || to >= vertex_count_) {
+    throw std::out_of_range("Vertex id is out of range");
+  }
+  // Путь собирается проходом по одной строке массива рёбер
+  const TableEdgeId *row_edges = prev_edges_data_ + from * vertex_count_;
+  if (row_edges[to] == TABLE_NO_ROUTE) {
     return std::nullopt;
   }
-  const Weight weight = route_internal_data->weight;
   std::vector <EdgeId> edges;
-  for (std::optional <EdgeId> edge_id = route_internal_data->prev_edge;
-       edge_id;
-       edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge) {
-    edges.push_back(*edge_id);
+  for (TableEdgeId edge_id = row_edges[to]; edge_id != TABLE_NO_EDGE;
+       edge_id = row_edges[graph_.GetEdge(edge_id).from]) {
+    edges.push_back(edge_id);
   }
   std::reverse(edges.begin(), edges.end());
 
-  return RouteInfo{weight, std::move(edges)};
+  return RouteInfo{weights_data_[from * vertex_count_ + to], std::move(edges)};
+}
+
+template<typename Weight>
+void Router<Weight>::Save(serialization::Writer &writer) const {
+  writer.WriteArray(weights_data_, vertex_count_ * vertex_count_);
+  writer.WriteArray(prev_edges_data_, vertex_count_ * vertex_count_);
+}
+
+template<typename Weight>
+bool Router<Weight>::OnEdgeWeightChanged(EdgeId edge_id, Weight old_weight) {
+  const auto &edge = graph_.GetEdge(edge_id);
+  CheckEdgeWeight(edge.weight);
+  if (weights_data_ != weights_.data()) {
+    ResizeTable(vertex_count_);
+  }
+  if (edge.weight < old_weight) {
+    RelaxThroughEdge(edge_id);
+  } else if (old_weight < edge.weight) {
+    // Остальные строки обходятся без этого ребра, и их пути остаются кратчайшими
+    for (VertexId vertex_from = 0; vertex_from < vertex_count_; ++vertex_from) {
+      if (prev_edges_[vertex_from * vertex_count_ + edge.to] == edge_id) {
+        RecomputeRow(vertex_from);
+      }
+    }
+  }
+  return true;
+}
+
+template<typename Weight>
+bool Router<Weight>::OnEdgesAdded(EdgeId first_new_edge) {
+  CheckEdgeCount();
+  if (weights_data_ != weights_.data() || vertex_count_ != graph_.GetVertexCount()) {
+    ResizeTable(graph_.GetVertexCount());
+  }
+  // Новое ребро — то же, что ребро, вес которого уменьшился с бесконечности
+  for (EdgeId edge_id = first_new_edge; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+    CheckEdgeWeight(graph_.GetEdge(edge_id).weight);
+    RelaxThroughEdge(edge_id);
+  }
+  return true;
 }
 
 }  // namespace graph
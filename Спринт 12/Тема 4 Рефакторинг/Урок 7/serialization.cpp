@@ -0,0 +1,173 @@
+#include "serialization.h"
+
+#include <fstream>
+#include <unordered_map>
+
+using namespace serialization;
+
+namespace {
+
+// Сигнатура и версия формата в начале снимка
+constexpr uint64_t MAGIC = 0x315041534e435454;  // "TTCNSAP1"
+constexpr uint32_t VERSION = 5;
+
+struct SavedDistance {
+  uint32_t from;
+  uint32_t to;
+  uint64_t distance;
+};
+
+void SaveCatalogue(Writer &writer, const tc::TransportCatalogue &catalogue) {
+  const auto stops = catalogue.GetAllStops();
+  std::unordered_map<const tc::Stop *, uint32_t> stop_indexes;
+  writer.Write(static_cast<uint64_t>(stops.size()));
+  for (const auto &stop : stops) {
+    stop_indexes.emplace(stop, static_cast<uint32_t>(stop_indexes.size()));
+    writer.WriteString(stop->name_);
+    writer.Write(stop->coordinates_);
+  }
+
+  const auto routes = catalogue.GetAllRoutes();
+  writer.Write(static_cast<uint64_t>(routes.size()));
+  std::vector<uint32_t> route_stops;
+  for (const auto &route : routes) {
+    writer.WriteString(route->name_);
+    writer.Write(static_cast<uint32_t>(route->is_rounded));
+    writer.Write(route->schedule_);
+    route_stops.clear();
+    for (const auto &stop : route->stops_) {
+      route_stops.push_back(stop_indexes.at(stop));
+    }
+    writer.WriteArray(route_stops.data(), route_stops.size());
+  }
+
+  std::vector<SavedDistance> distances;
+  catalogue.ForEachDistance([&distances, &stop_indexes](const tc::Stop *from, const tc::Stop *to, size_t distance) {
+    distances.push_back({stop_indexes.at(from), stop_indexes.at(to), distance});
+  });
+  writer.WriteArray(distances.data(), distances.size());
+}
+
+void LoadCatalogue(Reader &reader, tc::TransportCatalogue &catalogue) {
+  std::vector<std::string_view> stopnames(reader.Read<uint64_t>());
+  for (auto &stopname : stopnames) {
+    stopname = reader.ReadString();
+    catalogue.AddStop(std::string(stopname), reader.Read<geo::Coordinates>());
+  }
+
+  const auto route_count = reader.Read<uint64_t>();
+  std::vector<std::string_view> route_stops;
+  for (uint64_t i = 0; i < route_count; ++i) {
+    const std::string routename(reader.ReadString());
+    const bool is_rounded = reader.Read<uint32_t>() != 0;
+    const auto schedule = reader.Read<tc::RouteSchedule>();
+    route_stops.clear();
+    for (const uint32_t stop_idx : reader.ReadArray<uint32_t>()) {
+      route_stops.push_back(stopnames.at(stop_idx));
+    }
+    catalogue.AddRoute(routename, route_stops, is_rounded, schedule);
+  }
+
+  for (const auto &[from, to, distance] : reader.ReadArray<SavedDistance>()) {
+    catalogue.SetDistance({catalogue.GetStop(stopnames.at(from)), catalogue.GetStop(stopnames.at(to))}, distance);
+  }
+  catalogue.Finalize();
+}
+
+void SaveColor(Writer &writer, const svg::Color &color) {
+  writer.Write(static_cast<uint32_t>(color.index()));
+  if (const auto *name = std::get_if<std::string>(&color)) {
+    writer.WriteString(*name);
+  } else if (const auto *rgb = std::get_if<svg::Rgb>(&color)) {
+    writer.Write(*rgb);
+  } else if (const auto *rgba = std::get_if<svg::Rgba>(&color)) {
+    writer.Write(*rgba);
+  }
+}
+
+svg::Color LoadColor(Reader &reader) {
+  switch (reader.Read<uint32_t>()) {
+    case 1:
+      return std::string(reader.ReadString());
+    case 2:
+      return reader.Read<svg::Rgb>();
+    case 3:
+      return reader.Read<svg::Rgba>();
+    default:
+      return svg::NoneColor;
+  }
+}
+
+void SaveRenderSettings(Writer &writer, const renderer::Params &params) {
+  writer.Write(params.height_);
+  writer.Write(params.line_width_);
+  writer.Write(params.padding_);
+  writer.Write(params.stop_radius_);
+  writer.Write(params.underlayer_width_);
+  writer.Write(params.width_);
+  writer.Write(params.route_label_font_size_);
+  writer.Write(params.stop_label_font_size_);
+  writer.Write(params.route_label_offset_.first);
+  writer.Write(params.route_label_offset_.second);
+  writer.Write(params.stop_label_offset_.first);
+  writer.Write(params.stop_label_offset_.second);
+  writer.Write(static_cast<uint64_t>(params.color_palette_.size()));
+  for (const auto &color : params.color_palette_) {
+    SaveColor(writer, color);
+  }
+  SaveColor(writer, params.underlayer_color_);
+}
+
+renderer::Params LoadRenderSettings(Reader &reader) {
+  renderer::Params params;
+  params.height_ = reader.Read<double>();
+  params.line_width_ = reader.Read<double>();
+  params.padding_ = reader.Read<double>();
+  params.stop_radius_ = reader.Read<double>();
+  params.underlayer_width_ = reader.Read<double>();
+  params.width_ = reader.Read<double>();
+  params.route_label_font_size_ = reader.Read<unsigned>();
+  params.stop_label_font_size_ = reader.Read<unsigned>();
+  params.route_label_offset_.first = reader.Read<double>();
+  params.route_label_offset_.second = reader.Read<double>();
+  params.stop_label_offset_.first = reader.Read<double>();
+  params.stop_label_offset_.second = reader.Read<double>();
+  params.color_palette_.resize(reader.Read<uint64_t>());
+  for (auto &color : params.color_palette_) {
+    color = LoadColor(reader);
+  }
+  params.underlayer_color_ = LoadColor(reader);
+  return params;
+}
+
+}  // namespace
+
+void serialization::SaveBase(const Settings &settings,
+                             const tc::TransportCatalogue &catalogue,
+                             const renderer::Params &render_settings,
+                             const router::Router &router) {
+  std::ofstream out(settings.file, std::ios::binary);
+  if (!out) {
+    throw SnapshotError("Failed to create snapshot " + settings.file.string());
+  }
+  Writer writer(out);
+  writer.Write(MAGIC);
+  writer.Write(VERSION);
+  SaveCatalogue(writer, catalogue);
+  SaveRenderSettings(writer, render_settings);
+  router.Save(writer);
+  if (!out) {
+    throw SnapshotError("Failed to write snapshot " + settings.file.string());
+  }
+}
+
+LoadedBase::LoadedBase(const Settings &settings)
+    : file_(settings.file) {
+  Reader reader(file_.GetData(), file_.GetSize());
+  if (reader.Read<uint64_t>() != MAGIC || reader.Read<uint32_t>() != VERSION) {
+    throw SnapshotError("Unsupported snapshot format " + settings.file.string());
+  }
+  LoadCatalogue(reader, catalogue_);
+  render_settings_ = LoadRenderSettings(reader);
+  router_ = std::make_unique<router::Router>(catalogue_, reader);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "map_renderer.h"
+#include "snapshot.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <filesystem>
+#include <memory>
+
+namespace serialization {
+
+struct Settings {
+  std::filesystem::path file;
+};
+
+/**
+ * Сохраняет в бинарный снимок справочник, настройки визуализации и построенный маршрутизатор
+ * вместе с его предпосчитанными таблицами
+ */
+void SaveBase(const Settings &settings,
+              const tc::TransportCatalogue &catalogue,
+              const renderer::Params &render_settings,
+              const router::Router &router);
+
+/*
+ * Транспортная база, восстановленная из снимка. Файл снимка отображается в память, справочник
+ * восстанавливается за линейное время, а граф и таблицы маршрутизатора читаются из снимка без перестроения.
+ * Маршрутизатор ссылается на справочник и на отображённый файл, поэтому объект нельзя копировать и перемещать
+ */
+class LoadedBase {
+ public:
+  explicit LoadedBase(const Settings &settings);
+  LoadedBase(const LoadedBase &) = delete;
+  LoadedBase &operator=(const LoadedBase &) = delete;
+
+  const tc::TransportCatalogue &GetCatalogue() const {
+    return catalogue_;
+  }
+
+  const renderer::Params &GetRenderSettings() const {
+    return render_settings_;
+  }
+
+  const router::Router &GetRouter() const {
+    return *router_;
+  }
+
+ private:
+  MappedFile file_;
+  tc::TransportCatalogue catalogue_;
+  renderer::Params render_settings_;
+  std::unique_ptr<router::Router> router_;
+};
+
+}  // namespace serialization
@@ -0,0 +1,37 @@
+#include "snapshot.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace serialization;
+
+MappedFile::MappedFile(const std::filesystem::path &path) {
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd == -1) {
+    throw SnapshotError("Failed to open snapshot " + path.string());
+  }
+  struct stat file_stat{};
+  if (fstat(fd, &file_stat) == -1) {
+    close(fd);
+    throw SnapshotError("Failed to stat snapshot " + path.string());
+  }
+  size_ = static_cast<size_t>(file_stat.st_size);
+  if (size_ != 0) {
+    void *data = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+      close(fd);
+      throw SnapshotError("Failed to map snapshot " + path.string());
+    }
+    data_ = static_cast<const char *>(data);
+  }
+  // Отображение остаётся действительным и после закрытия дескриптора
+  close(fd);
+}
+
+MappedFile::~MappedFile() {
+  if (data_ != nullptr) {
+    munmap(const_cast<char *>(data_), size_);
+  }
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include "ranges.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <ostream>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+
+namespace serialization {
+
+class SnapshotError : public std::runtime_error {
+ public:
+  using runtime_error::runtime_error;
+};
+
+/*
+ * Последовательно записывает в поток значения и массивы тривиально копируемых типов в машинном представлении.
+ * Каждое значение выравнивается по 8 байт, чтобы после отображения файла в память массивы можно было
+ * читать на месте, без копирования. Формат не переносим между платформами с разным порядком байт
+ */
+class Writer {
+ public:
+  explicit Writer(std::ostream &out) : out_(out) {}
+
+  template<typename T>
+  void Write(const T &value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    WriteBytes(&value, sizeof(T));
+  }
+
+  template<typename T>
+  void WriteArray(const T *data, size_t size) {
+    BeginArray<T>(size);
+    WriteArrayPart(data, size);
+    EndArray();
+  }
+
+  // Массив можно записывать частями: сначала размер, затем все элементы одним или несколькими вызовами
+  template<typename T>
+  void BeginArray(size_t size) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    Write<uint64_t>(size);
+  }
+
+  template<typename T>
+  void WriteArrayPart(const T *data, size_t size) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    out_.write(reinterpret_cast<const char *>(data), static_cast<std::streamsize>(size * sizeof(T)));
+    offset_ += size * sizeof(T);
+  }
+
+  void EndArray() {
+    Align();
+  }
+
+  void WriteString(std::string_view str) {
+    WriteArray(str.data(), str.size());
+  }
+
+ private:
+  void WriteBytes(const void *data, size_t size) {
+    out_.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+    offset_ += size;
+    Align();
+  }
+
+  void Align() {
+    static const char zeros[ALIGNMENT] = {};
+    if (const size_t tail = offset_ % ALIGNMENT; tail != 0) {
+      out_.write(zeros, static_cast<std::streamsize>(ALIGNMENT - tail));
+      offset_ += ALIGNMENT - tail;
+    }
+  }
+
+  static constexpr size_t ALIGNMENT = 8;
+  std::ostream &out_;
+  size_t offset_ = 0;
+};
+
+/*
+ * Читает данные, записанные Writer-ом, из непрерывного буфера (как правило, из отображённого в память файла).
+ * Массивы и строки возвращаются как представления внутрь буфера и живут, пока жив сам буфер
+ */
+class Reader {
+ public:
+  Reader(const char *data, size_t size) : data_(data), size_(size) {}
+
+  template<typename T>
+  T Read() {
+    static_assert(std::is_trivially_copyable_v<T>);
+    T value;
+    std::memcpy(&value, Take(sizeof(T)), sizeof(T));
+    return value;
+  }
+
+  template<typename T>
+  ranges::Range<const T *> ReadArray() {
+    static_assert(std::is_trivially_copyable_v<T>);
+    const auto size = Read<uint64_t>();
+    if (size > (size_ - offset_) / sizeof(T)) {
+      throw SnapshotError("Snapshot is truncated");
+    }
+    const auto *begin = reinterpret_cast<const T *>(Take(size * sizeof(T)));
+    return {begin, begin + size};
+  }
+
+  std::string_view ReadString() {
+    const auto chars = ReadArray<char>();
+    return {chars.begin(), static_cast<size_t>(chars.end() - chars.begin())};
+  }
+
+ private:
+  const char *Take(size_t size) {
+    if (size > size_ - offset_) {
+      throw SnapshotError("Snapshot is truncated");
+    }
+    const char *result = data_ + offset_;
+    offset_ += size;
+    offset_ = std::min(size_, (offset_ + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT);
+    return result;
+  }
+
+  static constexpr size_t ALIGNMENT = 8;
+  const char *data_;
+  size_t size_;
+  size_t offset_ = 0;
+};
+
+/*
+ * Отображает файл в память только для чтения. Несколько процессов, отобразивших один и тот же файл,
+ * разделяют его страницы в кэше операционной системы
+ */
+class MappedFile {
+ public:
+  explicit MappedFile(const std::filesystem::path &path);
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  ~MappedFile();
+
+  const char *GetData() const {
+    return data_;
+  }
+
+  size_t GetSize() const {
+    return size_;
+  }
+
+ private:
+  const char *data_ = nullptr;
+  size_t size_ = 0;
+};
+
+}  // namespace serialization
@@ -0,0 +1,111 @@
+#include "spatial_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace geo;
+
+SpatialIndex::SpatialIndex(const std::vector<Coordinates> &points)
+    : coordinates_(points) {
+  if (points.size() >= std::numeric_limits<uint32_t>::max()) {
+    throw std::length_error("Too many points for the spatial index");
+  }
+  nodes_.reserve(points.size());
+  for (size_t i = 0; i < points.size(); ++i) {
+    nodes_.push_back({ToPoint3D(points[i]), static_cast<uint32_t>(i), 0});
+  }
+  Build(0, nodes_.size());
+}
+
+double SpatialIndex::GetCoordinate(const Point3D &point, uint32_t axis) {
+  return axis == 0 ? point.x : axis == 1 ? point.y : point.z;
+}
+
+void SpatialIndex::Build(size_t begin, size_t end) {
+  if (end - begin <= 1) {
+    return;
+  }
+  // Поддиапазон делится по оси, вдоль которой его точки разбросаны сильнее всего
+  Point3D min = nodes_[begin].point;
+  Point3D max = min;
+  for (size_t i = begin + 1; i < end; ++i) {
+    const Point3D &point = nodes_[i].point;
+    min = {std::min(min.x, point.x), std::min(min.y, point.y), std::min(min.z, point.z)};
+    max = {std::max(max.x, point.x), std::max(max.y, point.y), std::max(max.z, point.z)};
+  }
+  const double spreads[] = {max.x - min.x, max.y - min.y, max.z - min.z};
+  const auto axis = static_cast<uint32_t>(std::max_element(std::begin(spreads), std::end(spreads)) - spreads);
+
+  const size_t mid = begin + (end - begin) / 2;
+  std::nth_element(nodes_.begin() + begin, nodes_.begin() + mid, nodes_.begin() + end,
+                   [axis](const Node &lhs, const Node &rhs) {
+                     return GetCoordinate(lhs.point, axis) < GetCoordinate(rhs.point, axis);
+                   });
+  nodes_[mid].axis = axis;
+  Build(begin, mid);
+  Build(mid + 1, end);
+}
+
+std::vector<SpatialIndex::Neighbor> SpatialIndex::FindNearest(Coordinates point, size_t max_count,
+                                                              double max_distance) const {
+  if (max_count == 0 || nodes_.empty() || max_distance < 0) {
+    return {};
+  }
+  // Хорда, стягивающая дугу длины max_distance; дуги длиннее половины окружности не бывает
+  double max_chord_sq = std::numeric_limits<double>::infinity();
+  if (max_distance < M_PI * EARTH_RADIUS) {
+    const double max_chord = 2 * EARTH_RADIUS * std::sin(max_distance / (2 * EARTH_RADIUS));
+    // Небольшой запас, чтобы округление не отбросило точки на самой границе: их проверит ComputeDistance
+    max_chord_sq = max_chord * max_chord * (1 + 1e-9) + 1e-6;
+  }
+
+  Candidates candidates;
+  candidates.reserve(std::min(max_count, nodes_.size()));
+  Search(0, nodes_.size(), ToPoint3D(point), max_count, max_chord_sq, candidates);
+
+  std::vector<Neighbor> neighbors;
+  neighbors.reserve(candidates.size());
+  for (const auto &[chord_sq, index] : candidates) {
+    const double distance = ComputeDistance(point, coordinates_[index]);
+    if (distance <= max_distance) {
+      neighbors.push_back({index, distance});
+    }
+  }
+  std::sort(neighbors.begin(), neighbors.end(), [](const Neighbor &lhs, const Neighbor &rhs) {
+    return lhs.distance < rhs.distance || (lhs.distance == rhs.distance && lhs.index < rhs.index);
+  });
+  return neighbors;
+}
+
+void SpatialIndex::Search(size_t begin, size_t end, const Point3D &point, size_t max_count, double &max_chord_sq,
+                          Candidates &candidates) const {
+  if (begin >= end) {
+    return;
+  }
+  const size_t mid = begin + (end - begin) / 2;
+  const Node &node = nodes_[mid];
+  const double dx = node.point.x - point.x;
+  const double dy = node.point.y - point.y;
+  const double dz = node.point.z - point.z;
+  if (const double chord_sq = dx * dx + dy * dy + dz * dz; chord_sq <= max_chord_sq) {
+    candidates.emplace_back(chord_sq, node.index);
+    std::push_heap(candidates.begin(), candidates.end());
+    if (candidates.size() > max_count) {
+      std::pop_heap(candidates.begin(), candidates.end());
+      candidates.pop_back();
+    }
+    // Когда кандидатов набралось max_count, искать имеет смысл только ближе самого дальнего из них
+    if (candidates.size() == max_count) {
+      max_chord_sq = std::min(max_chord_sq, candidates.front().first);
+    }
+  }
+
+  // Сначала обходится половина, в которой лежит сама точка: там вероятнее найти близких соседей
+  const double offset = GetCoordinate(point, node.axis) - GetCoordinate(node.point, node.axis);
+  const bool is_left_first = offset < 0;
+  Search(is_left_first ? begin : mid + 1, is_left_first ? mid : end, point, max_count, max_chord_sq, candidates);
+  if (offset * offset <= max_chord_sq) {
+    Search(is_left_first ? mid + 1 : begin, is_left_first ? end : mid, point, max_count, max_chord_sq, candidates);
+  }
+}
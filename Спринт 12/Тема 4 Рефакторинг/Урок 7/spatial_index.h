@@ -0,0 +1,56 @@
+#pragma once
+
+#include "geo.h"
+
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace geo {
+
+/*
+ * Пространственный индекс точек на поверхности Земли: k-d дерево по декартовым координатам точек (ToPoint3D).
+ * Расстояние по поверхности монотонно растёт вместе с длиной хорды, поэтому ближайшие по хорде точки —
+ * ближайшие и по поверхности, а радиус по поверхности однозначно переводится в радиус хорды.
+ * Дерево неявное: узел поддиапазона массива — его середина, левое и правое поддеревья — половины по обе
+ * стороны от неё. Построение O(n log n), поиск k ближайших — в среднем O(log n + k)
+ */
+class SpatialIndex {
+ public:
+  struct Neighbor {
+    size_t index;     // Номер точки в массиве, по которому построен индекс
+    double distance;  // Расстояние по поверхности, как у ComputeDistance, в метрах
+  };
+
+  SpatialIndex() = default;
+  explicit SpatialIndex(const std::vector<Coordinates> &points);
+
+  /**
+   * До max_count ближайших к point точек на расстоянии не больше max_distance метров по возрастанию расстояния,
+   * при равном расстоянии — по возрастанию номера
+   */
+  std::vector<Neighbor> FindNearest(Coordinates point, size_t max_count,
+                                    double max_distance = std::numeric_limits<double>::infinity()) const;
+
+ private:
+  struct Node {
+    Point3D point;
+    uint32_t index;  // Номер точки в исходном массиве
+    uint32_t axis;   // Ось, по которой узел делит своё поддерево: 0 — x, 1 — y, 2 — z
+  };
+
+  // Кандидаты поиска: максимальная куча по квадрату хорды, наверху самый дальний
+  using Candidates = std::vector<std::pair<double, uint32_t>>;
+
+  void Build(size_t begin, size_t end);
+  void Search(size_t begin, size_t end, const Point3D &point, size_t max_count, double &max_chord_sq,
+              Candidates &candidates) const;
+
+  static double GetCoordinate(const Point3D &point, uint32_t axis);
+
+  std::vector<Node> nodes_;
+  std::vector<Coordinates> coordinates_;
+};
+
+}  // namespace geo
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "json.h"
+
+#include <iostream>
+
+namespace json_reference {
+
+// Прежний разбор JSON посимвольно из потока, эталон для сравнения с json::Load.
+// Результат и тексты ошибок те же, что у json::Load
+json::Document Load(std::istream &input);
+
+}  // namespace json_reference
@@ -0,0 +1,307 @@
+/*
+ * Сравнительный тест разбора JSON. Каждый текст разбирается эталонным посимвольным разбором
+ * (json_reference::Load) и всеми путями json.cpp: Load из строки и из потока, Parse из строки и из потока
+ * с обработчиком, собирающим Node, и ViewDocument. Результаты и тексты ошибок должны совпасть. Повторы ключей
+ * Parse не проверяет, поэтому такие тексты для него пропускаются.
+ * Тексты — встроенные крайние случаи, документ больше блока чтения, файлы корпуса из командной строки,
+ * их случайные искажения и массивы строк со спецсимволами и пробельными промежутками случайной длины.
+ *
+ * Сборка из каталога урока:
+ *   g++ -std=c++17 -O2 -I. tests/json_test.cpp tests/json_reference.cpp json.cpp json_builder.cpp -o json_test
+ * Прогонять нужно три сборки: как есть (поиск на SSE2), с -U__SSE2__ (тот же поиск по одному байту)
+ * и с -DJSON_INPUT_BLOCK_SIZE=7 (лексемы длиннее блока чтения, Input::Refill переносит их почти на каждом шаге).
+ * Запуск:
+ *   ./json_test [файлы корпуса...]
+ * Код возврата 1, если хоть один путь разошёлся с эталоном
+ */
+#include "json.h"
+#include "json_builder.h"
+#include "tests/json_reference.h"
+
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std::literals;
+
+namespace {
+
+// Собирает Node из событий Parse
+class BuildingHandler final : public json::Handler {
+ public:
+  void StartDict() override {
+    builder_.StartDict();
+  }
+  void Key(std::string_view key) override {
+    builder_.Key(std::string(key));
+  }
+  void EndDict() override {
+    builder_.EndDict();
+  }
+  void StartArray() override {
+    builder_.StartArray();
+  }
+  void EndArray() override {
+    builder_.EndArray();
+  }
+  void String(std::string_view value) override {
+    builder_.Value(std::string(value));
+  }
+  void Value(json::Node::Value value) override {
+    builder_.Value(std::move(value));
+  }
+
+  json::Node Build() {
+    return builder_.Build();
+  }
+
+ private:
+  json::Builder builder_;
+};
+
+json::Node ToNode(const json::ViewNode &node) {
+  if (node.IsNull()) {
+    return nullptr;
+  }
+  if (node.IsBool()) {
+    return node.AsBool();
+  }
+  if (node.IsInt()) {
+    return node.AsInt();
+  }
+  if (node.IsPureDouble()) {
+    return node.AsDouble();
+  }
+  if (node.IsString()) {
+    return std::string(node.AsString());
+  }
+  if (node.IsArray()) {
+    json::Array array;
+    for (const auto &item : node.AsArray()) {
+      array.push_back(ToNode(item));
+    }
+    return array;
+  }
+  json::Dict dict;
+  for (const auto &[key, value] : node.AsDict()) {
+    dict.emplace(std::string(key), ToNode(value));
+  }
+  return dict;
+}
+
+// Разобранное значение или текст ошибки
+struct Outcome {
+  std::string error;
+  json::Node node;
+
+  bool operator==(const Outcome &other) const {
+    return error == other.error && node == other.node;
+  }
+};
+
+Outcome Run(const std::function<json::Node()> &parse) {
+  try {
+    return {{}, parse()};
+  } catch (const json::ParsingError &e) {
+    return {"ParsingError: "s + e.what(), nullptr};
+  } catch (const std::exception &e) {
+    return {"exception: "s + e.what(), nullptr};
+  }
+}
+
+class Tester {
+ public:
+  void Check(const std::string &text) {
+    ++checked_;
+    const Outcome expected = Run([&text] {
+      std::istringstream input(text);
+      return json_reference::Load(input).GetRoot();
+    });
+    const bool is_duplicate_key = expected.error.find("Duplicate key"sv) != std::string::npos;
+
+    Compare("Load(string_view)"sv, text, expected, Run([&text] {
+      return json::Load(std::string_view(text)).GetRoot();
+    }));
+    Compare("Load(istream)"sv, text, expected, Run([&text] {
+      std::istringstream input(text);
+      return json::Load(input).GetRoot();
+    }));
+    if (!is_duplicate_key) {
+      Compare("Parse(string_view)"sv, text, expected, Run([&text] {
+        BuildingHandler handler;
+        json::Parse(std::string_view(text), handler);
+        return handler.Build();
+      }));
+      Compare("Parse(istream)"sv, text, expected, Run([&text] {
+        BuildingHandler handler;
+        std::istringstream input(text);
+        json::Parse(input, handler);
+        return handler.Build();
+      }));
+    }
+    Compare("ViewDocument"sv, text, expected, Run([&text] {
+      const json::ViewDocument document(text);
+      return ToNode(document.GetRoot());
+    }));
+  }
+
+  size_t GetCheckedCount() const {
+    return checked_;
+  }
+
+  size_t GetMismatchCount() const {
+    return mismatches_;
+  }
+
+ private:
+  void Compare(std::string_view path, const std::string &text, const Outcome &expected, const Outcome &actual) {
+    if (actual == expected) {
+      return;
+    }
+    // Подробности только о первых расхождениях, остальные лишь считаются
+    if (++mismatches_ <= 10) {
+      std::cout << path << " differs on "sv << text.size() << " bytes ["sv << text.substr(0, 60) << "]: expected "sv
+                << (expected.error.empty() ? "value"s : expected.error) << ", got "sv
+                << (actual.error.empty() ? "value"s : actual.error) << '\n';
+    }
+  }
+
+  size_t checked_ = 0;
+  size_t mismatches_ = 0;
+};
+
+const std::vector<std::string> EDGE_CASES = {
+    "", " ", "1", "-", "-0", "01", "1.", "1e", "1e+", "2147483647", "2147483648", "-2147483648", "-2147483649",
+    "1e400", "1e-400", "4.9e-324", "0.5e-3", "-0.0", "1E5", "[1,,2]", "[,1]", "[1 2 3]", "[true,false,null]",
+    "{\"a\":1,\"a\":2}", "{\"a\":{\"b\":1,\"b\":2}}", "{\"a\" 1}", "{\"a\":", "{,}", "{1:2}", "\"abc", "\"a\\x\"",
+    "\"a\nb\"", "\"a\rb\"", "\"\\\"\\\\\\n\\t\\r\"", "tru", "nul", "truex", "nullx", "\xc3\xa9", "[\"\xff\"]",
+    "  \v\f[ ]", "[[[[]]]]", "{\"\":{\"\":[]}}", "[\"0123456789abcdef0123456789\\\"abcdef\"]"};
+
+// Документ в формате входа программы, который больше блока чтения из потока
+std::string MakeLargeDocument() {
+  std::string text = "{\"base_requests\": ["s;
+  for (int i = 0; i < 3000; ++i) {
+    if (i != 0) {
+      text += ",\n    ";
+    }
+    text += "{\"type\": \"Stop\", \"name\": \"Stop \\\"" + std::to_string(i) + "\\\" on the long street name\", "
+        + "\"latitude\": 55." + std::to_string(i) + ", \"longitude\": -37.5e0, \"road_distances\": {\"Stop "
+        + std::to_string(i + 1) + "\": " + std::to_string(i * 7) + "}}";
+  }
+  text += "], \"stat_requests\": [], \"flag\": true, \"none\": null}";
+  return text;
+}
+
+std::string ReadFile(const char *path) {
+  std::ifstream input(path, std::ios::binary);
+  std::ostringstream text;
+  text << input.rdbuf();
+  return text.str();
+}
+
+// Случайное искажение текста: обрезка, замена или вставка символов либо текст из случайных символов
+std::string Mutate(std::string text, std::mt19937 &random_engine) {
+  static const std::string alphabet = "{}[]\",:\\ \n\t0123456789-+.eEtrufalsn\x01\xff";
+  auto random_char = [&random_engine] {
+    return alphabet[random_engine() % alphabet.size()];
+  };
+  // Из длинных текстов берётся кусок, чтобы искажения не терялись в объёме
+  if (text.size() > 4000) {
+    const size_t offset = random_engine() % (text.size() - 4000);
+    text = text.substr(0, 1) + text.substr(offset, 4000);
+  }
+  switch (random_engine() % 4) {
+    case 0:
+      text.resize(random_engine() % (text.size() + 1));
+      break;
+    case 1:
+      for (int i = 0; i < 3 && !text.empty(); ++i) {
+        text[random_engine() % text.size()] = random_char();
+      }
+      break;
+    case 2:
+      text.insert(random_engine() % (text.size() + 1), 1, random_char());
+      break;
+    default:
+      text.clear();
+      for (size_t i = random_engine() % 30; i > 0; --i) {
+        text += random_char();
+      }
+  }
+  return text;
+}
+
+// Массив строк со спецсимволами и escape-последовательностями в случайных местах, в том числе на границах
+// 16-байтовых блоков поиска, между пробельными промежутками случайной длины
+std::string MakeStringArray(std::mt19937 &random_engine) {
+  static const std::string string_chars = "abcdefgh \"\\\n\r\t\v\f\x01\x7f\x80\xff";
+  static const std::string space_chars = " \t\n\v\f\r";
+  std::string text = "[";
+  const size_t item_count = random_engine() % 6;
+  for (size_t item = 0; item < item_count; ++item) {
+    for (size_t i = random_engine() % 40; i > 0; --i) {
+      text += random_engine() % 8 != 0 ? ' ' : space_chars[random_engine() % space_chars.size()];
+    }
+    if (random_engine() % 20 == 0) {
+      text += 'x';
+    }
+    text += '"';
+    for (size_t i = random_engine() % 70; i > 0; --i) {
+      const char c = random_engine() % 10 != 0 ? static_cast<char>('a' + random_engine() % 26)
+                                               : string_chars[random_engine() % string_chars.size()];
+      if (c == '\\' && random_engine() % 2 != 0) {
+        text += "\\n";
+      } else if ((c == '\\' || c == '"') && random_engine() % 3 != 0) {
+        text += '\\';
+        text += c;
+      } else {
+        text += c;
+      }
+    }
+    text += '"';
+    for (size_t i = random_engine() % 40; i > 0; --i) {
+      text += space_chars[random_engine() % space_chars.size()];
+    }
+    if (item + 1 < item_count) {
+      text += ',';
+    }
+  }
+  text += ']';
+  if (random_engine() % 4 == 0) {
+    text.resize(random_engine() % (text.size() + 1));
+  }
+  return text;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  Tester tester;
+  for (const auto &text : EDGE_CASES) {
+    tester.Check(text);
+  }
+
+  std::vector<std::string> corpus = {MakeLargeDocument()};
+  for (int i = 1; i < argc; ++i) {
+    corpus.push_back(ReadFile(argv[i]));
+  }
+  for (const auto &text : corpus) {
+    tester.Check(text);
+  }
+
+  std::mt19937 random_engine(42);
+  for (int i = 0; i < 20000; ++i) {
+    tester.Check(Mutate(corpus[random_engine() % corpus.size()], random_engine));
+  }
+  for (int i = 0; i < 20000; ++i) {
+    tester.Check(MakeStringArray(random_engine));
+  }
+
+  std::cout << "checked "sv << tester.GetCheckedCount() << " texts, mismatches "sv << tester.GetMismatchCount()
+            << '\n';
+  return tester.GetMismatchCount() == 0 ? 0 : 1;
+}
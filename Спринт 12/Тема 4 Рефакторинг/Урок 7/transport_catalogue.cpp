@@ -5,27 +5,85 @@
 using namespace tc;
 
 void TransportCatalogue::AddStop(const std::string &name, const geo::Coordinates &coordinates) {
-  tc::Stop stop{name, coordinates, {}};
-  stops_.push_back(stop);
+  stops_.push_back({StoreName(name), coordinates, {nullptr, nullptr}, static_cast<StopId>(stops_.size())});
   stopname_to_stop_.insert({stops_.back().name_, &stops_.back()});
+  stop_points_.Add(coordinates);
+  stop_index_.reset();
 }
 
 void TransportCatalogue::AddRoute(const std::string &name,
                                   const std::vector<std::string_view> &stops,
-                                  bool is_rounded) {
-  Route route{name, {}, is_rounded};
-  routes_.push_back(std::move(route));
+                                  bool is_rounded,
+                                  const RouteSchedule &schedule) {
+  routes_.push_back({StoreName(name), std::pmr::vector<const Stop *>(&arena_), is_rounded, schedule,
+                     static_cast<RouteId>(routes_.size())});
+  // Массив остановок выделяется в arena_ сразу по размеру: освободить память от перевыделений арена не может
+  routes_.back().stops_.reserve(stops.size());
 
   for (const auto &stop_name : stops) {
-    auto *find_stop = stopname_to_stop_.at(stop_name);
-    find_stop->routes_.push_back(&routes_.back());
-    routes_.back().stops_.push_back(find_stop);
+    routes_.back().stops_.push_back(stopname_to_stop_.at(stop_name));
   }
 
   routename_to_route_.insert({routes_.back().name_, &routes_.back()});
+  route_infos_.push_back(std::make_unique<RouteInfoSlot>());
+}
+
+void TransportCatalogue::Finalize() {
+  // Как в RaptorRouter: сначала считаем, сколько маршрутов через каждую остановку, затем раскладываем по местам.
+  // Остановка может встречаться на маршруте несколько раз, маршрут записывается один раз
+  constexpr RouteId NO_ROUTE = std::numeric_limits<RouteId>::max();
+  std::vector<RouteId> last_route(stops_.size(), NO_ROUTE);
+  std::vector<size_t> offsets(stops_.size() + 1, 0);
+  for (const Route &route : routes_) {
+    for (const Stop *stop : route.stops_) {
+      if (last_route[stop->id_] != route.id_) {
+        last_route[stop->id_] = route.id_;
+        ++offsets[stop->id_ + 1];
+      }
+    }
+  }
+  for (size_t stop = 0; stop < stops_.size(); ++stop) {
+    offsets[stop + 1] += offsets[stop];
+  }
+
+  // Прежний массив освобождается целиком, указатели остановок в него тут же заменяются
+  stop_routes_.assign(offsets.back(), nullptr);
+  std::vector<size_t> fill_positions(offsets.begin(), offsets.end() - 1);
+  std::fill(last_route.begin(), last_route.end(), NO_ROUTE);
+  for (const Route &route : routes_) {
+    for (const Stop *stop : route.stops_) {
+      if (last_route[stop->id_] != route.id_) {
+        last_route[stop->id_] = route.id_;
+        stop_routes_[fill_positions[stop->id_]++] = &route;
+      }
+    }
+  }
+  for (Stop &stop : stops_) {
+    const Route *const *begin = stop_routes_.data();
+    stop.routes_ = {begin + offsets[stop.id_], begin + offsets[stop.id_ + 1]};
+  }
 
-  for (const auto &stop : routes_.back().stops_)
-    stopname_to_routenames_[stop->name_].insert(routes_.back().name_);
+  // Названия маршрутов каждой остановки сортируются на своём месте. Повторяться могут только названия
+  // разных маршрутов с одним именем, поэтому после удаления повторов массив больше нужного разве что на них
+  stop_routenames_.clear();
+  stop_routenames_.reserve(stop_routes_.size());
+  stop_routename_offsets_.assign(1, 0);
+  stop_routename_offsets_.reserve(stops_.size() + 1);
+  for (const Stop &stop : stops_) {
+    for (const Route *route : stop.routes_) {
+      stop_routenames_.push_back(route->name_);
+    }
+    const auto first = stop_routenames_.begin() + static_cast<std::ptrdiff_t>(stop_routename_offsets_.back());
+    std::sort(first, stop_routenames_.end());
+    stop_routenames_.erase(std::unique(first, stop_routenames_.end()), stop_routenames_.end());
+    stop_routename_offsets_.push_back(stop_routenames_.size());
+  }
+}
+
+std::string_view TransportCatalogue::StoreName(std::string_view name) {
+  char *data = static_cast<char *>(arena_.allocate(name.size(), alignof(char)));
+  std::copy(name.begin(), name.end(), data);
+  return {data, name.size()};
 }
 
 const Route *TransportCatalogue::GetRoute(const std::string_view &name) const {
@@ -38,18 +96,34 @@ const Stop *TransportCatalogue::GetStop(const std::string_view &name) const {
   return it == stopname_to_stop_.end() ? nullptr : it->second;
 }
 
-const std::set<std::string_view> &TransportCatalogue::GetRoutes(const std::string_view &stop_name) const {
-  static std::set<std::string_view> empty;
-  if (GetStop(stop_name) == nullptr) {
-    // Если такой остановки нет, метод at выкинет исключение за нас, которое будет обработано
-    return stopname_to_routenames_.at(stop_name);
-  } else if (stopname_to_routenames_.find(stop_name) == stopname_to_routenames_.end()) {
-    // Если остановка есть, но через неё не проходит ни один маршрут, возвращаем пустой список маршрутов
-    return empty;
-  } else return stopname_to_routenames_.at(stop_name);
+const Route *TransportCatalogue::GetRouteById(RouteId id) const {
+  return &routes_.at(id);
 }
 
-size_t CountUniqueStops(const std::vector<const Stop *> &stops) {
+const Stop *TransportCatalogue::GetStopById(StopId id) const {
+  return &stops_.at(id);
+}
+
+size_t TransportCatalogue::GetStopCount() const {
+  return stops_.size();
+}
+
+size_t TransportCatalogue::GetRouteCount() const {
+  return routes_.size();
+}
+
+TransportCatalogue::RouteNames TransportCatalogue::GetRoutes(const std::string_view &stop_name) const {
+  // Если такой остановки нет, метод at выкинет исключение за нас, которое будет обработано.
+  // Если остановка есть, но через неё не проходит ни один маршрут или она добавлена после Finalize, список пуст
+  const StopId id = stopname_to_stop_.at(stop_name)->id_;
+  if (id + size_t{1} >= stop_routename_offsets_.size()) {
+    return {nullptr, nullptr};
+  }
+  const std::string_view *names = stop_routenames_.data();
+  return {names + stop_routename_offsets_[id], names + stop_routename_offsets_[id + 1]};
+}
+
+size_t CountUniqueStops(const std::pmr::vector<const Stop *> &stops) {
   std::unordered_set<std::string_view> names;
   for (const auto &stop : stops)
     names.insert(stop->name_);
@@ -63,38 +137,78 @@ double ComputeLineDistanceRoute(const std::vector<Stop *> &stops) {
   return route_distance;
 }
 
-double ComputeDirectDistanceRoute(const std::vector<const Stop *> &stops) {
+double ComputeDirectDistanceRoute(const std::pmr::vector<const Stop *> &stops, const geo::SpherePoints &stop_points) {
+  geo::SpherePoints route_points;
+  route_points.Reserve(stops.size());
+  for (const auto &stop : stops)
+    route_points.AddFrom(stop_points, stop->id_);
   double route_distance = 0;
-  for (size_t begin = 0, end = stops.size(); begin < (end - 1); ++begin)
-    route_distance += ComputeDistance(stops.at(begin)->coordinates_, stops.at(begin + 1)->coordinates_);
+  for (const double distance : route_points.ComputeSegmentDistances())
+    route_distance += distance;
   return route_distance;
 }
 
 RouteInfo TransportCatalogue::GetRouteInfo(const std::string_view &name) const {
   const auto route = routename_to_route_.at(name);
+  RouteInfoSlot &slot = *route_infos_[route->id_];
+  std::call_once(slot.computed, [this, route, &slot] {
+    slot.info = ComputeRouteInfo(*route);
+    slot.is_computed = true;
+  });
+  return slot.info;
+}
+
+void TransportCatalogue::ResetRouteInfo(RouteId route_id) {
+  if (auto &slot = route_infos_[route_id]; slot->is_computed) {
+    slot = std::make_unique<RouteInfoSlot>();
+  }
+}
+
+std::vector<NearbyStop> TransportCatalogue::FindNearbyStops(geo::Coordinates point, size_t max_count,
+                                                            double max_distance) const {
+  std::vector<geo::SpatialIndex::Neighbor> neighbors;
+  {
+    std::lock_guard lock(stop_index_mutex_);
+    if (!stop_index_) {
+      std::vector<geo::Coordinates> coordinates;
+      coordinates.reserve(stops_.size());
+      for (const auto &stop : stops_) {
+        coordinates.push_back(stop.coordinates_);
+      }
+      stop_index_.emplace(coordinates);
+    }
+    neighbors = stop_index_->FindNearest(point, max_count, max_distance);
+  }
+
+  std::vector<NearbyStop> nearby_stops;
+  nearby_stops.reserve(neighbors.size());
+  for (const auto &[index, distance] : neighbors) {
+    nearby_stops.push_back({&stops_[index], distance});
+  }
+  return nearby_stops;
+}
+
+RouteInfo TransportCatalogue::ComputeRouteInfo(const Route &route) const {
   size_t real_route_length = 0;
-  for (size_t i = 0; i < route->stops_.size() - 1; ++i)
-    real_route_length += GetDistance({route->stops_.at(i), route->stops_.at(i + 1)});
+  for (size_t i = 0; i < route.stops_.size() - 1; ++i)
+    real_route_length += GetDistance({route.stops_.at(i), route.stops_.at(i + 1)});
 
-  return {route->stops_.size(), CountUniqueStops(route->stops_), ComputeDirectDistanceRoute(route->stops_),
+  return {route.stops_.size(), CountUniqueStops(route.stops_), ComputeDirectDistanceRoute(route.stops_, stop_points_),
           real_route_length};
 }
 
 void TransportCatalogue::SetDistance(const std::pair<const Stop *, const Stop *> &stops, size_t distance) {
-  distances_.insert({stops, distance});
+  // Повторный вызов для той же пары остановок заменяет расстояние, так справочник принимает исправления
+  distances_.Set(stops.first->id_, stops.second->id_, distance);
+  // Пролёт в любую сторону между этими остановками есть только на маршрутах через первую из них
+  for (const Route *route : stops.first->routes_) {
+    ResetRouteInfo(route->id_);
+  }
 }
 
 size_t TransportCatalogue::GetDistance(const std::pair<const Stop *, const Stop *> &stops) const {
-  auto it = distances_.find(stops);
-
-  if (it == distances_.end()) {
-    it = distances_.find({stops.second, stops.first});
-    if (it == distances_.end()) {
-      return std::numeric_limits<size_t>::max();
-    }
-  }
-
-  return it->second;
+  // Если расстояние в эту сторону не задано, таблица вернёт обратное, а если нет и его — DistanceTable::NO_DISTANCE
+  return distances_.Get(stops.first->id_, stops.second->id_);
 }
 
 std::vector<const Route *> TransportCatalogue::GetSortedAllNonEmptyRoutes() const {
@@ -115,3 +229,19 @@ std::vector<const Stop *> TransportCatalogue::GetSortedAllNonEmptyStops() const
   std::sort(ret.begin(), ret.end(), [](const auto lhs, const auto rhs) { return lhs->name_ < rhs->name_; });
   return ret;
 }
+
+std::vector<const Route *> TransportCatalogue::GetAllRoutes() const {
+  std::vector<const Route *> ret;
+  ret.reserve(routes_.size());
+  for (const auto &route : routes_)
+    ret.push_back(&route);
+  return ret;
+}
+
+std::vector<const Stop *> TransportCatalogue::GetAllStops() const {
+  std::vector<const Stop *> ret;
+  ret.reserve(stops_.size());
+  for (const auto &stop : stops_)
+    ret.push_back(&stop);
+  return ret;
+}
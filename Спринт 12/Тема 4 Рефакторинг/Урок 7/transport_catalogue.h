@@ -1,41 +1,111 @@
 #pragma once
 
+#include "distance_table.h"
 #include "domain.h"
 #include "geo.h"
+#include "spatial_index.h"
 
 #include <deque>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <unordered_map>
 #include <unordered_set>
-#include <set>
 #include <vector>
 
 namespace tc {
 
 class TransportCatalogue {
  public:
+  using RouteNames = ranges::Range<const std::string_view *>;
+
   void AddStop(const std::string& name, const geo::Coordinates& coordinates);
-  void AddRoute(const std::string& name, const std::vector<std::string_view>& stops, bool is_rounded);
+  void AddRoute(const std::string& name, const std::vector<std::string_view>& stops, bool is_rounded,
+                const RouteSchedule& schedule = {});
   void SetDistance(const std::pair<const Stop *, const Stop *>& stops, size_t distance);
+  // Строит списки маршрутов через остановки после добавления маршрутов. До вызова у новых маршрутов нет
+  // остановок в этих списках, поэтому вызывать его нужно до запросов и после каждого добавления маршрутов
+  void Finalize();
 
   const Route *GetRoute(const std::string_view& name) const;
   const Stop *GetStop(const std::string_view& name) const;
+  const Route *GetRouteById(RouteId id) const;
+  const Stop *GetStopById(StopId id) const;
+  // Номера остановок и маршрутов идут подряд от нуля, эти методы дают размер массивов по номерам
+  size_t GetStopCount() const;
+  size_t GetRouteCount() const;
   size_t GetDistance(const std::pair<const Stop *, const Stop *>& stops) const;
-  const std::set<std::string_view>& GetRoutes(const std::string_view& stop_name) const;
+  // Названия маршрутов через остановку без повторов, по возрастанию. Списки строит Finalize
+  RouteNames GetRoutes(const std::string_view& stop_name) const;
   std::vector<const Route*> GetSortedAllNonEmptyRoutes() const;
   std::vector<const Stop*> GetSortedAllNonEmptyStops() const;
+  std::vector<const Route*> GetAllRoutes() const;
+  std::vector<const Stop*> GetAllStops() const;
+
+  // Вызывает visitor(from, to, distance) для каждого явно заданного расстояния
+  template<typename Visitor>
+  void ForEachDistance(Visitor &&visitor) const {
+    distances_.ForEachExplicit([this, &visitor](StopId from, StopId to, size_t distance) {
+      visitor(&stops_[from], &stops_[to], distance);
+    });
+  }
 
+  // Статистика маршрута считается при первом запросе и хранится до изменения расстояний на его остановках.
+  // Можно вызывать из нескольких потоков одновременно, но не одновременно с изменением справочника.
+  // Посчитанная статистика читается без блокировки, потоки ждут друг друга только при расчёте одного маршрута
   RouteInfo GetRouteInfo(const std::string_view& name) const;
 
+  // До max_count ближайших к point остановок не дальше max_distance метров по возрастанию расстояния.
+  // Пространственный индекс строится при первом запросе после добавления остановок, потоковая
+  // безопасность та же, что у GetRouteInfo
+  std::vector<NearbyStop> FindNearbyStops(geo::Coordinates point, size_t max_count,
+                                          double max_distance = std::numeric_limits<double>::infinity()) const;
+
  private:
-  std::deque<Stop> stops_;
-  std::deque<Route> routes_;
+  // Память под названия, остановки, маршруты и их списки смежности. Она только выделяется и освобождается
+  // целиком в деструкторе, поэтому объявлена первой: остальные поля разрушаются раньше неё
+  std::pmr::monotonic_buffer_resource arena_;
+  std::pmr::deque<Stop> stops_{&arena_};
+  std::pmr::deque<Route> routes_{&arena_};
   std::unordered_map<std::string_view, Stop *> stopname_to_stop_;
   std::unordered_map<std::string_view, Route *> routename_to_route_;
+  // Маршруты через остановки подряд по номерам остановок, Stop::routes_ указывает в этот массив.
+  // Он строится целиком в Finalize по точному размеру и вне arena_, поэтому перестройка не оставляет мусора
+  std::vector<const Route *> stop_routes_;
+
+  // Названия маршрутов через остановки подряд по номерам остановок, у каждой остановки — по возрастанию
+  // без повторов. Названия остановки stop лежат с stop_routename_offsets_[stop] по stop_routename_offsets_[stop + 1].
+  // Как и stop_routes_, строятся в Finalize один раз и вне arena_
+  std::vector<std::string_view> stop_routenames_;
+  std::vector<size_t> stop_routename_offsets_;
+  DistanceTable distances_;
+  // Точки остановок на сфере по номеру остановки для пакетного расчёта расстояний
+  geo::SpherePoints stop_points_;
+
+  // Копирует название в arena_: все названия-ключи справочника указывают в неё
+  std::string_view StoreName(std::string_view name);
+  RouteInfo ComputeRouteInfo(const Route &route) const;
+
+  // Статистика маршрута: считается один раз первым запросившим её потоком
+  struct RouteInfoSlot {
+    std::once_flag computed;
+    RouteInfo info;
+    bool is_computed = false;  // Читается только при изменении справочника, когда запросов нет
+  };
+
+  // Сбрасывает статистику маршрута, если она уже посчитана: флаг std::once_flag не сбросить, поэтому ячейка новая
+  void ResetRouteInfo(RouteId route_id);
+
+  // Статистика маршрутов по номеру маршрута. Ячейки в куче, чтобы сброс одной не трогал остальные
+  mutable std::vector<std::unique_ptr<RouteInfoSlot>> route_infos_;
 
-  std::unordered_map<std::string_view, std::set<std::string_view>> stopname_to_routenames_;
-  std::unordered_map<std::pair<const Stop *, const Stop *>, size_t, StopsPairHasher> distances_;
+  // Индекс координат остановок, номер точки в нём — номер остановки
+  mutable std::mutex stop_index_mutex_;
+  mutable std::optional<geo::SpatialIndex> stop_index_;
 };
 
 }
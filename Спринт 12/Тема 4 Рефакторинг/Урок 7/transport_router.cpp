@@ -1,92 +1,651 @@
 #include "transport_catalogue.h"
 #include "transport_router.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <system_error>
+#include <thread>
+#include <unordered_set>
+
 using namespace router;
 
+namespace {
+
+// Значение перечисления, записанное в снимок числом, SnapshotError — если такого значения у перечисления нет
+template<typename Enum>
+Enum ToEnum(uint32_t value, Enum last, const std::string &name) {
+  if (value > static_cast<uint32_t>(last)) {
+    throw serialization::SnapshotError("Unknown " + name + " in snapshot: " + std::to_string(value));
+  }
+  return static_cast<Enum>(value);
+}
+
+}  // namespace
+
 Router::Router(Params settings, const tc::TransportCatalogue &catalogue)
     : catalogue_(catalogue),
       params_(settings) {
   const auto &stops = catalogue.GetSortedAllNonEmptyStops();
   const auto &routes = catalogue.GetSortedAllNonEmptyRoutes();
-  const size_t vertex_count = stops.size() * 2;  // По две вершины на остановку
-  graph_ = graph::DirectedWeightedGraph<Minutes>(vertex_count);
-  vertex_idx_to_stopname_.reserve(catalogue.GetSortedAllNonEmptyStops().size() * 2);
-
   AddStopsToGraph(stops);
   AddRoutesToGraph(routes);
-  router_ = std::make_unique<graph::Router<Minutes>>(graph_);
+  graph_.Freeze();
+  router_ = MakeGraphRouter();
+  MakeRouteCache();
+}
+
+Router::Router(const tc::TransportCatalogue &catalogue, serialization::Reader &reader)
+    : catalogue_(catalogue) {
+  params_.bus_wait_time = Minutes(reader.Read<double>());
+  if (!(params_.bus_wait_time.count() >= 0)) {
+    throw serialization::SnapshotError("Negative bus wait time in snapshot");
+  }
+  params_.bus_velocity = reader.Read<double>();
+  params_.mode = ToEnum(reader.Read<uint32_t>(), RoutingMode::AStar, "routing mode");
+  params_.graph_model = ToEnum(reader.Read<uint32_t>(), GraphModel::Chain, "graph model");
+  params_.build_threads = reader.Read<uint64_t>();
+  params_.route_cache_capacity = reader.Read<uint64_t>();
+  params_.is_route_cache_thread_safe = reader.Read<uint32_t>() != 0;
+
+  // Номера остановок и маршрутов в снимке совпадают с номерами в справочнике, восстановленном из того же снимка
+  const auto stop_vertexes = reader.ReadArray<StopVertex>();
+  stop_vertexes_.assign(stop_vertexes.begin(), stop_vertexes.end());
+  if (stop_vertexes_.size() != catalogue.GetStopCount()) {
+    throw serialization::SnapshotError("Snapshot stops do not match the catalogue");
+  }
+  for (const uint32_t stop_id : reader.ReadArray<uint32_t>()) {
+    if (stop_id >= catalogue.GetStopCount()) {
+      throw serialization::SnapshotError("Unknown stop in snapshot: " + std::to_string(stop_id));
+    }
+    vertex_stops_.push_back(catalogue.GetStopById(stop_id));
+  }
+
+  graph_ = graph::DirectedWeightedGraph<Minutes>(reader.Read<uint64_t>());
+  const size_t vertex_count = graph_.GetVertexCount();
+  if (vertex_stops_.size() != vertex_count) {
+    throw serialization::SnapshotError("Snapshot vertex stops do not match the graph");
+  }
+  for (const auto &[in, out] : stop_vertexes_) {
+    const bool is_in_graph = in != NO_VERTEX || out != NO_VERTEX;
+    if (is_in_graph && (in >= vertex_count || out >= vertex_count)) {
+      throw serialization::SnapshotError("Unknown stop vertex in snapshot");
+    }
+  }
+  for (const auto &edge : reader.ReadArray<graph::Edge<Minutes>>()) {
+    if (edge.from >= vertex_count || edge.to >= vertex_count) {
+      throw serialization::SnapshotError("Unknown edge vertex in snapshot");
+    }
+    graph_.AddEdge(edge);
+  }
+  graph_.Freeze();
+  route_ride_edges_.resize(catalogue.GetRouteCount());
+  for (const auto &[kind, route_id, steps_count] : reader.ReadArray<SavedEdgeInfo>()) {
+    const auto edge_kind = ToEnum(kind, EdgeKind::Transfer, "edge kind");
+    const tc::Route *route = nullptr;
+    if (edge_kind == EdgeKind::Ride) {
+      if (route_id >= catalogue.GetRouteCount()) {
+        throw serialization::SnapshotError("Unknown route in snapshot: " + std::to_string(route_id));
+      }
+      route = catalogue.GetRouteById(route_id);
+      route_ride_edges_[route_id].push_back(edges_.size());
+    }
+    edges_.push_back({edge_kind, route, steps_count});
+  }
+  if (edges_.size() != graph_.GetEdgeCount()) {
+    throw serialization::SnapshotError("Snapshot edges do not match the graph");
+  }
+
+  if (params_.mode == RoutingMode::AllPairs) {
+    const auto weights = reader.ReadArray<Minutes>();
+    router_ = std::make_unique<graph::Router<Minutes>>(graph_, weights, reader.ReadArray<graph::TableEdgeId>());
+  } else if (params_.mode == RoutingMode::ContractionHierarchy) {
+    router_ = std::make_unique<graph::ContractionHierarchyRouter<Minutes>>(graph_, reader);
+  } else {
+    router_ = MakeGraphRouter();
+  }
+  MakeRouteCache();
+}
+
+void Router::Save(serialization::Writer &writer) const {
+  writer.Write(params_.bus_wait_time.count());
+  writer.Write(params_.bus_velocity);
+  writer.Write(static_cast<uint32_t>(params_.mode));
+  writer.Write(static_cast<uint32_t>(params_.graph_model));
+  writer.Write(static_cast<uint64_t>(params_.build_threads));
+  writer.Write(static_cast<uint64_t>(params_.route_cache_capacity));
+  writer.Write(static_cast<uint32_t>(params_.is_route_cache_thread_safe));
+
+  writer.WriteArray(stop_vertexes_.data(), stop_vertexes_.size());
+  std::vector<uint32_t> vertex_stop_ids;
+  vertex_stop_ids.reserve(vertex_stops_.size());
+  for (const tc::Stop *stop : vertex_stops_) {
+    vertex_stop_ids.push_back(stop->id_);
+  }
+  writer.WriteArray(vertex_stop_ids.data(), vertex_stop_ids.size());
+
+  std::vector<SavedEdgeInfo> saved_edges;
+  saved_edges.reserve(edges_.size());
+  for (const auto &edge_info : edges_) {
+    const uint32_t route_id = edge_info.kind == EdgeKind::Ride ? edge_info.route->id_ : 0;
+    saved_edges.push_back({static_cast<uint32_t>(edge_info.kind), route_id, edge_info.steps_count});
+  }
+
+  writer.Write(static_cast<uint64_t>(graph_.GetVertexCount()));
+  writer.BeginArray<graph::Edge<Minutes>>(graph_.GetEdgeCount());
+  for (graph::EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+    writer.WriteArrayPart(&graph_.GetEdge(edge_id), 1);
+  }
+  writer.EndArray();
+  writer.WriteArray(saved_edges.data(), saved_edges.size());
+
+  router_->Save(writer);
+}
+
+std::unique_ptr<graph::RouterBase<Minutes>> Router::MakeGraphRouter() const {
+  switch (params_.mode) {
+    case RoutingMode::AllPairs:
+      return std::make_unique<graph::Router<Minutes>>(
+          graph_, params_.build_threads == 0 ? std::thread::hardware_concurrency() : params_.build_threads);
+    case RoutingMode::Dijkstra:
+      return std::make_unique<graph::DijkstraRouter<Minutes>>(graph_);
+    case RoutingMode::ContractionHierarchy:
+      return std::make_unique<graph::ContractionHierarchyRouter<Minutes>>(graph_);
+    case RoutingMode::AStar:
+      return std::make_unique<graph::AStarRouter<Minutes>>(graph_, MakeTravelTimeLowerBound());
+  }
+  throw std::invalid_argument("Unknown routing mode");
+}
+
+void Router::UpdateDistance(const tc::Stop *from, const tc::Stop *to) {
+  // Расстояние в обратную сторону может браться из этой же записи, поэтому пересчитываются все маршруты
+  // через from: в них входят оба направления пролёта
+  std::vector<std::pair<graph::EdgeId, Minutes>> edge_weights;
+  std::unordered_set<tc::RouteId> updated_routes;
+  for (const tc::Route *route : from->routes_) {
+    if (route->id_ >= route_ride_edges_.size() || route_ride_edges_[route->id_].empty()
+        || !updated_routes.insert(route->id_).second) {
+      continue;
+    }
+    if (std::find(route->stops_.begin(), route->stops_.end(), to) == route->stops_.end()) {
+      continue;
+    }
+    const auto &ride_edges = route_ride_edges_[route->id_];
+    const auto ride_times = ComputeRideTimes(*route);
+    for (size_t i = 0; i < ride_times.size(); ++i) {
+      edge_weights.emplace_back(ride_edges[i], ride_times[i]);
+    }
+  }
+  UpdateEdgeWeights(edge_weights);
+  ResetLazyRouters();
+}
+
+RouteInfo Router::FindRoute(std::string_view from, std::string_view to, Minutes departure_time) const {
+  const tc::Stop *stop_from = catalogue_.GetStop(from);
+  const tc::Stop *stop_to = catalogue_.GetStop(to);
+  if (stop_from == nullptr || stop_to == nullptr) {
+    throw std::out_of_range("Unknown stop");
+  }
+  const auto journey = GetTimetable()->FindJourney(stop_from, stop_to, departure_time.count());
+  if (!journey) {
+    throw GraphError("Failed to build route");
+  }
+
+  RouteInfo route_info;
+  route_info.total_time = Minutes(journey->arrival_time) - departure_time;
+  route_info.items.reserve(journey->legs.size() * 2);
+  for (const auto &leg : journey->legs) {
+    route_info.items.emplace_back(RouteInfo::Waiting{leg.boarding_stop->name_, Minutes(leg.wait_time)});
+    route_info.items.emplace_back(RouteInfo::Moving{leg.route->name_, Minutes(leg.ride_time), leg.steps_count});
+  }
+  return route_info;
+}
+
+std::vector<RouteInfo> Router::FindParetoRoutes(std::string_view from, std::string_view to) const {
+  // Если такой остановки нет, GetStopVertex выкинет исключение за нас, как и в FindRoute
+  GetStopVertex(from);
+  GetStopVertex(to);
+  const auto pareto_router = GetParetoRouter();
+  const auto journeys = pareto_router->FindParetoJourneys(catalogue_.GetStop(from), catalogue_.GetStop(to));
+  if (journeys.empty()) {
+    throw GraphError("Failed to build route");
+  }
+
+  const Minutes wait_time(pareto_router->GetWaitTime());
+  std::vector<RouteInfo> routes;
+  routes.reserve(journeys.size());
+  for (const auto &journey : journeys) {
+    RouteInfo &route_info = routes.emplace_back();
+    route_info.total_time = Minutes(journey.total_time);
+    route_info.items.reserve(journey.legs.size() * 2);
+    for (const auto &leg : journey.legs) {
+      route_info.items.emplace_back(RouteInfo::Waiting{leg.boarding_stop->name_, wait_time});
+      route_info.items.emplace_back(RouteInfo::Moving{leg.route->name_, Minutes(leg.ride_time), leg.steps_count});
+    }
+  }
+  return routes;
+}
+
+std::shared_ptr<const ConnectionScanRouter> Router::GetTimetable() const {
+  std::lock_guard lock(lazy_routers_mutex_);
+  if (!timetable_) {
+    timetable_ = std::make_shared<ConnectionScanRouter>(catalogue_, params_.bus_wait_time.count(),
+                                                        params_.bus_velocity);
+  }
+  return timetable_;
+}
+
+std::shared_ptr<const RaptorRouter> Router::GetParetoRouter() const {
+  std::lock_guard lock(lazy_routers_mutex_);
+  if (!pareto_router_) {
+    pareto_router_ = std::make_shared<RaptorRouter>(catalogue_, params_.bus_wait_time.count(),
+                                                    params_.bus_velocity);
+  }
+  return pareto_router_;
+}
+
+void Router::ResetLazyRouters() {
+  std::lock_guard lock(lazy_routers_mutex_);
+  timetable_.reset();
+  pareto_router_.reset();
+}
+
+void Router::AddRoute(const tc::Route *route) {
+  if (route->id_ < route_ride_edges_.size() && !route_ride_edges_[route->id_].empty()) {
+    throw std::invalid_argument("Route " + std::string(route->name_) + " is already in the graph");
+  }
+  if (route->stops_.empty()) {
+    return;
+  }
+  const graph::EdgeId first_new_edge = graph_.GetEdgeCount();
+  graph_.Unfreeze();
+  AddStopsToGraph(route->stops_);
+  AddRoutesToGraph({route});
+  graph_.Freeze();
+  if (!router_->OnEdgesAdded(first_new_edge)) {
+    router_ = MakeGraphRouter();
+  }
+  if (route_cache_) {
+    route_cache_->Clear();
+  }
+  ResetLazyRouters();
+}
+
+void Router::SetBusWaitTime(Minutes bus_wait_time) {
+  params_.bus_wait_time = bus_wait_time;
+  std::vector<std::pair<graph::EdgeId, Minutes>> edge_weights;
+  for (graph::EdgeId edge_id = 0; edge_id < edges_.size(); ++edge_id) {
+    if (edges_[edge_id].kind == EdgeKind::Wait) {
+      edge_weights.emplace_back(edge_id, bus_wait_time);
+    }
+  }
+  UpdateEdgeWeights(edge_weights);
+  ResetLazyRouters();
+}
+
+void Router::UpdateEdgeWeights(const std::vector<std::pair<graph::EdgeId, Minutes>> &edge_weights) {
+  std::vector<std::pair<graph::EdgeId, Minutes>> changed_edges;
+  for (const auto &[edge_id, weight] : edge_weights) {
+    if (graph_.GetEdge(edge_id).weight != weight) {
+      changed_edges.emplace_back(edge_id, weight);
+    }
+  }
+  if (changed_edges.empty()) {
+    return;
+  }
+
+  // Рёбра меняются по одному, чтобы маршрутизатор видел граф, в котором изменилось ровно одно ребро
+  bool is_updated = changed_edges.size() <= MAX_PARTIAL_UPDATE_EDGES;
+  for (const auto &[edge_id, weight] : changed_edges) {
+    const Minutes old_weight = graph_.GetEdge(edge_id).weight;
+    graph_.SetEdgeWeight(edge_id, weight);
+    is_updated = is_updated && router_->OnEdgeWeightChanged(edge_id, old_weight);
+  }
+  if (!is_updated) {
+    router_ = MakeGraphRouter();
+  }
+  if (route_cache_) {
+    route_cache_->Clear();
+  }
+}
+
+void Router::MakeRouteCache() {
+  if (params_.route_cache_capacity > 0) {
+    route_cache_ = std::make_unique<RouteCache>(params_.route_cache_capacity, params_.is_route_cache_thread_safe);
+  }
+}
+
+Router::RouteCache::Stats Router::GetRouteCacheStats() const {
+  return route_cache_ ? route_cache_->GetStats() : RouteCache::Stats{};
 }
 
 RouteInfo Router::FindRoute(std::string_view from, std::string_view to) const {
-  // Если такой остановки нет, метод at выкинет исключение за нас, которое будет обработано
-  const graph::VertexId vertex_from = stopname_to_vertexes_.at(from).out;
-  const graph::VertexId vertex_to = stopname_to_vertexes_.at(to).out;
-  const auto route = router_->BuildRoute(vertex_from, vertex_to);
-  if (!route) {
+  // Если такой остановки нет, GetStopVertex выкинет исключение за нас, которое будет обработано
+  const graph::VertexId vertex_from = GetStopVertex(from).out;
+  const graph::VertexId vertex_to = GetStopVertex(to).out;
+
+  std::optional<RouteInfo> route_info;
+  if (route_cache_ && route_cache_->Find({vertex_from, vertex_to}, route_info)) {
+    // Ответ из кэша получен без поиска
+    if (route_info) {
+      route_info->search_stats = {};
+    }
+  } else {
+    if (const auto route = router_->BuildRoute(vertex_from, vertex_to)) {
+      route_info = MakeRouteInfo(*route);
+    }
+    if (route_cache_) {
+      route_cache_->Put({vertex_from, vertex_to}, route_info);
+    }
+  }
+  if (!route_info) {
     // Если не удалось построить маршрут, выкидываем исключение, которое будет обработано
     throw GraphError("Failed to build route");
   }
+  return std::move(*route_info);
+}
+
+std::vector<std::optional<RouteInfo>> Router::FindRoutes(const std::vector<RouteQuery> &queries,
+                                                         size_t thread_count) const {
+  struct SourceGroup {
+    graph::VertexId from;
+    std::vector<graph::VertexId> targets;
+    std::vector<size_t> query_indexes;
+  };
+
+  // Запросы с неизвестными остановками ни в одну группу не попадают и остаются без ответа,
+  // запросы, ответ на которые есть в кэше, тоже не нужно искать
+  std::vector<std::optional<RouteInfo>> routes(queries.size());
+  std::vector<SourceGroup> groups;
+  std::unordered_map<graph::VertexId, size_t> group_indexes;
+  for (size_t query_idx = 0; query_idx < queries.size(); ++query_idx) {
+    const StopVertex *from_vertex = FindStopVertex(queries[query_idx].first);
+    const StopVertex *to_vertex = FindStopVertex(queries[query_idx].second);
+    if (from_vertex == nullptr || to_vertex == nullptr) {
+      continue;
+    }
+    if (route_cache_ && route_cache_->Find({from_vertex->out, to_vertex->out}, routes[query_idx])) {
+      if (routes[query_idx]) {
+        routes[query_idx]->search_stats = {};
+      }
+      continue;
+    }
+    const auto [it, inserted] = group_indexes.emplace(from_vertex->out, groups.size());
+    if (inserted) {
+      groups.push_back({from_vertex->out, {}, {}});
+    }
+    auto &group = groups[it->second];
+    group.targets.push_back(to_vertex->out);
+    group.query_indexes.push_back(query_idx);
+  }
+
+  // Кэш пополняется в вызывающем потоке после всех поисков, так что потокобезопасность ему здесь не нужна
+  auto cache_found_routes = [this, &groups, &routes] {
+    if (!route_cache_) {
+      return;
+    }
+    for (const auto &group : groups) {
+      for (size_t i = 0; i < group.targets.size(); ++i) {
+        route_cache_->Put({group.from, group.targets[i]}, routes[group.query_indexes[i]]);
+      }
+    }
+  };
+
+  // Каждая группа пишет только в свои ячейки routes, поэтому потокам не нужна синхронизация
+  auto process_group = [this, &routes](const SourceGroup &group) {
+    const auto found_routes = router_->BuildRoutes(group.from, group.targets);
+    for (size_t i = 0; i < found_routes.size(); ++i) {
+      if (found_routes[i]) {
+        routes[group.query_indexes[i]] = MakeRouteInfo(*found_routes[i]);
+      }
+    }
+  };
+
+  const size_t core_count = std::thread::hardware_concurrency();
+  if (thread_count == 0 || (core_count != 0 && thread_count > core_count)) {
+    thread_count = core_count;
+  }
+  thread_count = std::clamp<size_t>(thread_count, 1, std::max<size_t>(groups.size(), 1));
+  if (thread_count == 1) {
+    for (const auto &group : groups) {
+      process_group(group);
+    }
+    cache_found_routes();
+    return routes;
+  }
+
+  // Поиски из разных остановок сильно различаются по времени, поэтому группы раздаются потокам по одной
+  std::atomic<size_t> next_group_idx{0};
+  auto process_groups = [&groups, &next_group_idx, &process_group] {
+    for (size_t group_idx = next_group_idx++; group_idx < groups.size(); group_idx = next_group_idx++) {
+      process_group(groups[group_idx]);
+    }
+  };
+  std::vector<std::thread> workers;
+  workers.reserve(thread_count - 1);
+  try {
+    for (size_t thread_idx = 1; thread_idx < thread_count; ++thread_idx) {
+      workers.emplace_back(process_groups);
+    }
+  } catch (const std::system_error &) {
+    // Группы разбирают потоки, которые успели запуститься, и этот поток
+  }
+  process_groups();
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  cache_found_routes();
+  return routes;
+}
+
+graph::AStarRouter<Minutes>::LowerBound Router::MakeTravelTimeLowerBound() const {
+  // Путь по дорогам между остановками не короче хорды между ними, умноженной на наименьшее
+  // по всем пролётам отношение длины пролёта к хорде между его концами
+  double min_ratio = std::numeric_limits<double>::infinity();
+  for (const auto &route : catalogue_.GetSortedAllNonEmptyRoutes()) {
+    for (size_t i = 0; i + 1 < route->stops_.size(); ++i) {
+      const tc::Stop *from = route->stops_[i];
+      const tc::Stop *to = route->stops_[i + 1];
+      const double chord = geo::ComputeChordDistance(geo::ToPoint3D(from->coordinates_),
+                                                     geo::ToPoint3D(to->coordinates_));
+      if (chord > 0) {
+        min_ratio = std::min(min_ratio, static_cast<double>(catalogue_.GetDistance({from, to})) / chord);
+      }
+    }
+  }
+  // Небольшой запас, чтобы ошибки округления не сделали оценку больше точного времени
+  const double scale = std::isfinite(min_ratio) ? min_ratio * (1 - 1e-9) : 0.;
 
+  std::vector<geo::Point3D> points;
+  points.reserve(vertex_stops_.size());
+  for (const tc::Stop *stop : vertex_stops_) {
+    points.push_back(geo::ToPoint3D(stop->coordinates_));
+  }
+  return [this, scale, points = std::move(points)](graph::VertexId from, graph::VertexId to) {
+    return ComputeRideTime(geo::ComputeChordDistance(points[from], points[to]) * scale);
+  };
+}
+
+RouteInfo Router::MakeRouteInfo(const graph::RouterBase<Minutes>::RouteInfo &route) const {
   RouteInfo route_info;
-  route_info.total_time = route->weight;
-  route_info.items.reserve(route->edges.size());
+  route_info.total_time = route.weight;
+  route_info.search_stats = route.stats;
+  route_info.items.reserve(route.edges.size());
 
-  for (const auto &edge_id : route->edges) {
+  // В модели GraphModel::Chain поездка состоит из нескольких рёбер подряд,
+  // их нужно склеить в один элемент Moving
+  bool is_riding = false;
+  for (const auto &edge_id : route.edges) {
     const auto &edge = graph_.GetEdge(edge_id);
-    const auto &route_edge_info = edges_[edge_id];
-    if (route_edge_info.has_value()) {
-      route_info.items.emplace_back(RouteInfo::Moving{
-          route_edge_info->routename,
-          edge.weight,
-          route_edge_info->steps_count,
-      });
-    } else {
-      const graph::VertexId vertex_id = edge.from;
-      route_info.items.emplace_back(RouteInfo::Waiting{
-          vertex_idx_to_stopname_[vertex_id],
-          edge.weight,
-      });
+    const auto &edge_info = edges_[edge_id];
+    switch (edge_info.kind) {
+      case EdgeKind::Ride:
+        if (is_riding) {
+          auto &moving = std::get<RouteInfo::Moving>(route_info.items.back());
+          moving.time += edge.weight;
+          moving.steps_count += edge_info.steps_count;
+        } else {
+          route_info.items.emplace_back(RouteInfo::Moving{
+              edge_info.route->name_,
+              edge.weight,
+              edge_info.steps_count,
+          });
+          is_riding = true;
+        }
+        break;
+      case EdgeKind::Wait:
+        route_info.items.emplace_back(RouteInfo::Waiting{
+            vertex_stops_[edge.from]->name_,
+            edge.weight,
+        });
+        is_riding = false;
+        break;
+      case EdgeKind::Transfer:
+        break;
     }
   }
   return route_info;
 }
 
-void Router::AddStopsToGraph(const std::vector<const tc::Stop *> &stops) {
-  // Вершины нумеруются с 0 до stops.size() * 2 - 1
-  graph::VertexId vertex_id = 0;
+const Router::StopVertex *Router::FindStopVertex(std::string_view stopname) const {
+  const tc::Stop *stop = catalogue_.GetStop(stopname);
+  if (stop == nullptr || stop->id_ >= stop_vertexes_.size() || stop_vertexes_[stop->id_].out == NO_VERTEX) {
+    return nullptr;
+  }
+  return &stop_vertexes_[stop->id_];
+}
 
-  for (const auto &stop : stops) {
-    StopVertex &vertex = stopname_to_vertexes_[stop->name_];
+const Router::StopVertex &Router::GetStopVertex(std::string_view stopname) const {
+  const StopVertex *vertex = FindStopVertex(stopname);
+  if (vertex == nullptr) {
+    throw std::out_of_range("Unknown stop " + std::string(stopname));
+  }
+  return *vertex;
+}
+
+graph::VertexId Router::AddVertex(const tc::Stop *stop) {
+  vertex_stops_.push_back(stop);
+  return graph_.AddVertex();
+}
+
+void Router::AddEdge(const graph::Edge<Minutes> &edge, EdgeInfo info) {
+  const graph::EdgeId edge_id = graph_.AddEdge(edge);
+  edges_.push_back(info);
+  if (info.kind == EdgeKind::Ride) {
+    if (info.route->id_ >= route_ride_edges_.size()) {
+      route_ride_edges_.resize(info.route->id_ + 1);
+    }
+    route_ride_edges_[info.route->id_].push_back(edge_id);
+  }
+}
 
-    vertex.in = vertex_id++;
-    vertex.out = vertex_id++;
-    vertex_idx_to_stopname_[vertex.in] = stop->name_;
-    vertex_idx_to_stopname_[vertex.out] = stop->name_;
+Minutes Router::ComputeRideTime(double distance) const {
+  return Minutes(distance / (params_.bus_velocity * 1000 / 60.0));
+}
 
-    edges_.emplace_back(std::nullopt);
-    graph_.AddEdge({vertex.out, vertex.in, params_.bus_wait_time});
+template<typename StopList>
+void Router::AddStopsToGraph(const StopList &stops) {
+  // Вершины нумеруются по порядку: у каждой новой остановки пара вершин in и out.
+  // Остановки, которые уже есть в графе, пропускаются
+  stop_vertexes_.resize(catalogue_.GetStopCount());
+  for (const auto &stop : stops) {
+    StopVertex &vertex = stop_vertexes_[stop->id_];
+    if (vertex.out != NO_VERTEX) {
+      continue;
+    }
+    vertex.in = AddVertex(stop);
+    vertex.out = AddVertex(stop);
+
+    AddEdge({vertex.out, vertex.in, params_.bus_wait_time}, {EdgeKind::Wait});
   }
 }
 
 void Router::AddRoutesToGraph(const std::vector<const tc::Route *> &routes) {
+  switch (params_.graph_model) {
+    case GraphModel::Complete:
+      AddRoutesAsCompleteGraphs(routes);
+      break;
+    case GraphModel::Chain:
+      AddRoutesAsChains(routes);
+      break;
+  }
+}
+
+std::vector<Minutes> Router::ComputeRideTimes(const tc::Route &route) const {
+  const auto &route_stops = route.stops_;
+  const size_t stop_count = route_stops.size();
+  std::vector<Minutes> ride_times;
+  if (stop_count <= 1) {
+    return ride_times;
+  }
+  auto compute_distance_from = [this, &route_stops](size_t stop_idx) {
+    return catalogue_.GetDistance({route_stops[stop_idx], route_stops[stop_idx + 1]});
+  };
+  switch (params_.graph_model) {
+    case GraphModel::Complete:
+      // Рёбра из каждой остановки во все следующие
+      ride_times.reserve(stop_count * (stop_count - 1) / 2);
+      for (size_t begin_i = 0; begin_i + 1 < stop_count; ++begin_i) {
+        size_t total_distance = 0;
+        for (size_t end_i = begin_i + 1; end_i < stop_count; ++end_i) {
+          total_distance += compute_distance_from(end_i - 1);
+          ride_times.push_back(ComputeRideTime(total_distance));
+        }
+      }
+      break;
+    case GraphModel::Chain:
+      // Рёбра между соседними остановками
+      ride_times.reserve(stop_count - 1);
+      for (size_t i = 0; i + 1 < stop_count; ++i) {
+        ride_times.push_back(ComputeRideTime(compute_distance_from(i)));
+      }
+      break;
+  }
+  return ride_times;
+}
+
+void Router::AddRoutesAsCompleteGraphs(const std::vector<const tc::Route *> &routes) {
   for (const auto &route : routes) {
     const auto &route_stops = route->stops_;
     const size_t stop_count = route_stops.size();
+    const auto ride_times = ComputeRideTimes(*route);
+    auto ride_time = ride_times.begin();
+    for (size_t begin_i = 0; begin_i + 1 < stop_count; ++begin_i) {
+      const graph::VertexId start = stop_vertexes_[route_stops[begin_i]->id_].in;
+      for (size_t end_i = begin_i + 1; end_i < stop_count; ++end_i) {
+        AddEdge({start, stop_vertexes_[route_stops[end_i]->id_].out, *ride_time++},
+                {EdgeKind::Ride, route, end_i - begin_i});
+      }
+    }
+  }
+}
+
+void Router::AddRoutesAsChains(const std::vector<const tc::Route *> &routes) {
+  for (const auto &route : routes) {
+    const auto &route_stops = route->stops_;
+    const size_t stop_count = route_stops.size();
+    // Вершины остановок маршрута нумеруются подряд следом за уже добавленными вершинами
+    const graph::VertexId first_vertex = graph_.GetVertexCount();
+    for (const auto &stop : route_stops) {
+      AddVertex(stop);
+    }
     if (stop_count <= 1) {
       continue;
     }
-    auto compute_distance_from = [this, &route_stops](size_t stop_idx) {
-      return catalogue_.GetDistance({route_stops[stop_idx], route_stops[stop_idx + 1]});
-    };
-    for (size_t begin_i = 0; begin_i + 1 < stop_count; ++begin_i) {
-      const graph::VertexId start = stopname_to_vertexes_.at(route_stops[begin_i]->name_).in;
-      size_t total_distance = 0;
-      for (size_t end_i = begin_i + 1; end_i < stop_count; ++end_i) {
-        total_distance += compute_distance_from(end_i - 1);
-        edges_.emplace_back(RouteEdge{route->name_, end_i - begin_i});
-        graph_.AddEdge({start,
-                        stopname_to_vertexes_.at(route_stops[end_i]->name_).out,
-                        Minutes(static_cast<double>(total_distance) / (params_.bus_velocity * 1000 / 60.0))});
+
+    const auto ride_times = ComputeRideTimes(*route);
+    for (size_t i = 0; i < stop_count; ++i) {
+      const StopVertex &stop_vertex = stop_vertexes_[route_stops[i]->id_];
+      const graph::VertexId route_vertex = first_vertex + i;
+      if (i + 1 < stop_count) {
+        // Сесть в автобус можно на любой остановке, кроме конечной
+        AddEdge({stop_vertex.in, route_vertex, ZERO_TIME}, {EdgeKind::Transfer});
+        AddEdge({route_vertex, route_vertex + 1, ride_times[i]}, {EdgeKind::Ride, route, 1});
+      }
+      if (i > 0) {
+        // Выйти из автобуса можно на любой остановке, кроме начальной
+        AddEdge({route_vertex, stop_vertex.out, ZERO_TIME}, {EdgeKind::Transfer});
       }
     }
   }
@@ -1,14 +1,23 @@
 #pragma once
 
+#include "a_star_router.h"
+#include "connection_scan.h"
+#include "contraction_hierarchy.h"
+#include "dijkstra_router.h"
 #include "domain.h"
 #include "graph.h"
+#include "lru_cache.h"
+#include "raptor_router.h"
 #include "router.h"
+#include "snapshot.h"
 #include "transport_catalogue.h"
 
 #include <chrono>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <unordered_map>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -21,9 +30,30 @@ class GraphError : public std::runtime_error {
 
 using Minutes = std::chrono::duration<double, std::chrono::minutes::period>;
 
+// Алгоритм, которым маршрутизатор ищет кратчайшие пути
+enum class RoutingMode {
+  AllPairs,  // Предпосчёт всех пар вершин алгоритмом Флойда — Уоршелла при построении
+  Dijkstra,  // Поиск алгоритмом Дейкстры на каждый запрос
+  ContractionHierarchy,  // Иерархии сжатия, построенные при запуске, и двунаправленный поиск на каждый запрос
+  AStar,  // Двунаправленный A* с оценкой времени в пути по координатам остановок
+};
+
+// Способ представления автобусных маршрутов в графе
+enum class GraphModel {
+  Complete,  // Ребро между каждой парой остановок маршрута: O(n^2) рёбер на маршрут из n остановок
+  Chain,     // Своя вершина на каждую остановку маршрута и цепочка рёбер между соседними: O(n) рёбер
+};
+
 struct Params {
   Minutes bus_wait_time;
   double bus_velocity{};
+  RoutingMode mode = RoutingMode::Dijkstra;
+  GraphModel graph_model = GraphModel::Chain;
+  // Числа потоков ограничены числом ядер, 0 — по числу ядер
+  size_t build_threads = 1;  // Число потоков для построения RoutingMode::AllPairs
+  size_t query_threads = 1;  // Число потоков для Router::FindRoutes. В снимок не сохраняется
+  size_t route_cache_capacity = 0;  // Сколько последних ответов хранить в кэше маршрутов, 0 — без кэша
+  bool is_route_cache_thread_safe = false;  // Нужен, если FindRoute вызывается из нескольких потоков
 };
 
 struct RouteInfo {
@@ -41,34 +71,148 @@ struct RouteInfo {
   using Item = std::variant<Moving, Waiting>;
   std::vector<Item> items;
   Minutes total_time;
+  graph::SearchStats search_stats;  // Счётчики поиска, которым найден маршрут, нули для ответа из кэша
+};
+
+struct VertexPairHasher {
+  size_t operator()(const std::pair<graph::VertexId, graph::VertexId> &vertexes) const {
+    // Умножение на нечётную константу перемешивает биты первой вершины, чтобы пары (a, b) и (b, a) различались
+    return vertexes.first * 0x9E3779B97F4A7C15ull ^ vertexes.second;
+  }
 };
 
 class Router {
  public:
   Router(Params params, const tc::TransportCatalogue &catalogue);
+
+  /**
+   * Восстанавливает маршрутизатор из снимка, не перестраивая граф и предпосчитанные таблицы.
+   * Справочник должен быть восстановлен из того же снимка, а сам снимок — жить дольше маршрутизатора
+   */
+  Router(const tc::TransportCatalogue &catalogue, serialization::Reader &reader);
+
   RouteInfo FindRoute(std::string_view from, std::string_view to) const;
 
+  /**
+   * Ищет по расписанию маршрут с самым ранним прибытием при отправлении не раньше departure_time
+   * (от начала суток). Ожидание считается до ближайшего рейса, маршруты без своего расписания ходят
+   * с интервалом bus_wait_time. Расписание строится при первом таком запросе и не сохраняется в снимок.
+   * Если bus_wait_time нулевое, а у маршрута нет своего расписания, расписание не строится: std::invalid_argument
+   */
+  RouteInfo FindRoute(std::string_view from, std::string_view to, Minutes departure_time) const;
+
+  /**
+   * Ищет все оптимальные по Парето маршруты по паре (время в пути, число поездок на автобусах)
+   * в порядке возрастания числа поездок, последний из них самый быстрый. Модель времени та же, что у
+   * FindRoute без времени отправления. Данные для поиска строятся при первом запросе и не сохраняются в снимок
+   */
+  std::vector<RouteInfo> FindParetoRoutes(std::string_view from, std::string_view to) const;
+
+  using RouteQuery = std::pair<std::string_view, std::string_view>;
+
+  /**
+   * Отвечает на пачку запросов маршрутов: запросы группируются по начальной остановке, и на каждую
+   * остановку выполняется один поиск. Ответы идут в порядке запросов, std::nullopt означает, что остановки
+   * нет или маршрут не найден. Группы распределяются между thread_count потоками, 0 — по числу ядер
+   */
+  std::vector<std::optional<RouteInfo>> FindRoutes(const std::vector<RouteQuery> &queries,
+                                                   size_t thread_count = 1) const;
+
+  void Save(serialization::Writer &writer) const;
+
+  /**
+   * Учитывают изменения справочника без полной перестройки: меняются веса только зависимых рёбер,
+   * предпосчитанные данные обновляются по частям, если алгоритм это умеет (RoutingMode::AllPairs,
+   * RoutingMode::Dijkstra), иначе строятся заново. Справочник нужно изменить до вызова.
+   * Кэш маршрутов очищается. Нельзя вызывать одновременно с поиском маршрутов.
+   * UpdateDistance вызывается после нового SetDistance для from и to, AddRoute — после добавления маршрута
+   * в справочник и его Finalize (остановки маршрута, которых ещё нет в графе, тоже добавляются)
+   */
+  void UpdateDistance(const tc::Stop *from, const tc::Stop *to);
+  void AddRoute(const tc::Route *route);
+  void SetBusWaitTime(Minutes bus_wait_time);
+
+  using RouteCache = LruCache<std::pair<graph::VertexId, graph::VertexId>, std::optional<RouteInfo>,
+                              VertexPairHasher>;
+
+  // Попадания и промахи кэша маршрутов, нули, если кэш выключен
+  RouteCache::Stats GetRouteCacheStats() const;
+
  private:
+  // Пара вершин остановки в графе. У остановок, которых нет в графе, обе вершины NO_VERTEX
   struct StopVertex {
-    graph::VertexId in;
-    graph::VertexId out;
+    graph::VertexId in = NO_VERTEX;
+    graph::VertexId out = NO_VERTEX;
   };
 
-  struct RouteEdge {
-    std::string_view routename;
-    size_t steps_count;
+  enum class EdgeKind {
+    Wait,      // Ожидание автобуса на остановке
+    Ride,      // Поездка на автобусе через steps_count пролётов
+    Transfer,  // Посадка в автобус или выход из него в модели GraphModel::Chain, в ответ не попадает
+  };
+
+  struct EdgeInfo {
+    EdgeKind kind;
+    const tc::Route *route = nullptr;
+    size_t steps_count{};
+  };
+
+  // Представление EdgeInfo в снимке: вместо указателя на маршрут хранится его номер в справочнике
+  struct SavedEdgeInfo {
+    uint32_t kind;
+    uint32_t route_id;
+    uint64_t steps_count;
   };
 
-  void AddStopsToGraph(const std::vector<const tc::Stop *> &stops);
+  // Вершины остановки по её названию, std::out_of_range — если остановки нет в графе
+  const StopVertex &GetStopVertex(std::string_view stopname) const;
+  // То же для поиска без исключений: nullptr, если остановки нет в графе
+  const StopVertex *FindStopVertex(std::string_view stopname) const;
+  graph::VertexId AddVertex(const tc::Stop *stop);
+  // Принимает и список остановок справочника, и остановки маршрута
+  template<typename StopList>
+  void AddStopsToGraph(const StopList &stops);
   void AddRoutesToGraph(const std::vector<const tc::Route *> &routes);
+  void AddRoutesAsCompleteGraphs(const std::vector<const tc::Route *> &routes);
+  void AddRoutesAsChains(const std::vector<const tc::Route *> &routes);
+  void AddEdge(const graph::Edge<Minutes> &edge, EdgeInfo info);
+  void UpdateEdgeWeights(const std::vector<std::pair<graph::EdgeId, Minutes>> &edge_weights);
+  void MakeRouteCache();
+  Minutes ComputeRideTime(double distance) const;
+  // Время поездки по каждому ребру маршрута в том порядке, в каком эти рёбра добавляются в граф
+  std::vector<Minutes> ComputeRideTimes(const tc::Route &route) const;
+  graph::AStarRouter<Minutes>::LowerBound MakeTravelTimeLowerBound() const;
+  std::unique_ptr<graph::RouterBase<Minutes>> MakeGraphRouter() const;
+  RouteInfo MakeRouteInfo(const graph::RouterBase<Minutes>::RouteInfo &route) const;
+  std::shared_ptr<const ConnectionScanRouter> GetTimetable() const;
+  std::shared_ptr<const RaptorRouter> GetParetoRouter() const;
+  // Сбрасывает данные поиска, которые строятся по первому запросу
+  void ResetLazyRouters();
+
+  static constexpr Minutes ZERO_TIME{};
+  static constexpr graph::VertexId NO_VERTEX = static_cast<graph::VertexId>(-1);
+  // Если меняется больше рёбер, предпосчитанные данные выгоднее построить заново, чем обновлять по одному ребру
+  static constexpr size_t MAX_PARTIAL_UPDATE_EDGES = 64;
 
   const tc::TransportCatalogue &catalogue_;
   graph::DirectedWeightedGraph<Minutes> graph_;
-  std::unique_ptr<graph::Router<Minutes>> router_;
+  std::unique_ptr<graph::RouterBase<Minutes>> router_;
   Params params_;
-  std::unordered_map<std::string_view, StopVertex> stopname_to_vertexes_;
-  std::vector<std::string_view> vertex_idx_to_stopname_;
-  std::vector<std::optional<RouteEdge>> edges_;
+  // Вершины остановок по номеру остановки в справочнике и остановка каждой вершины
+  std::vector<StopVertex> stop_vertexes_;
+  std::vector<const tc::Stop *> vertex_stops_;
+  std::vector<EdgeInfo> edges_;
+  // Рёбра поездок каждого маршрута в порядке ComputeRideTimes по номеру маршрута в справочнике
+  std::vector<std::vector<graph::EdgeId>> route_ride_edges_;
+
+  // Кэш ответов по паре вершин; std::nullopt в значении означает, что маршрута нет
+  std::unique_ptr<RouteCache> route_cache_;
+
+  // Связи расписания для FindRoute с временем отправления и маршруты для FindParetoRoutes,
+  // строятся по первому запросу
+  mutable std::mutex lazy_routers_mutex_;
+  mutable std::shared_ptr<const ConnectionScanRouter> timetable_;
+  mutable std::shared_ptr<const RaptorRouter> pareto_router_;
 };
 
 }  // namespace tc::router